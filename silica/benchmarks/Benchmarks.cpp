@@ -0,0 +1,31 @@
+#include "Benchmarks.h"
+
+#include <cstring>
+#include <iostream>
+
+// silica_benchmarks [jobs|log]; runs everything without arguments
+int main(int argc, char** argv)
+{
+	bool jobs = argc < 2;
+	bool log = argc < 2;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "jobs") == 0)
+			jobs = true;
+		else if (std::strcmp(argv[i], "log") == 0)
+			log = true;
+		else
+		{
+			std::cerr << "Unknown benchmark '" << argv[i] << "', expected jobs or log\n";
+			return 1;
+		}
+	}
+
+	if (jobs)
+		silica::benchmarks::runJobSystemBenchmark();
+	if (log)
+		silica::benchmarks::runLogBenchmark();
+
+	return 0;
+}
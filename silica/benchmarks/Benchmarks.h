@@ -0,0 +1,15 @@
+#pragma once
+
+#include <chrono>
+
+namespace silica::benchmarks {
+
+	void runJobSystemBenchmark();
+	void runLogBenchmark();
+
+	inline double secondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+}
@@ -0,0 +1,124 @@
+#include "Benchmarks.h"
+
+#include "Core/JobSystem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace silica::benchmarks {
+
+	namespace {
+
+		constexpr size_t s_ParallelForItems = 1 << 22;
+		constexpr size_t s_ParallelForGrain = 1024;
+		constexpr uint32_t s_NestedParents = 256;
+		constexpr uint32_t s_NestedChildren = 256;
+		constexpr int s_Repetitions = 5;
+
+		// enough arithmetic per item that scheduling overhead doesn't dominate, cheap enough to expose it
+		float work(size_t i)
+		{
+			float x = (float)i;
+			for (int k = 0; k < 16; k++)
+				x = std::sqrt(x * 1.0001f + 1.0f);
+			return x;
+		}
+
+		double benchmarkParallelFor(std::vector<float>& output)
+		{
+			auto start = std::chrono::steady_clock::now();
+
+			JobSystem::parallelFor(0, output.size(), s_ParallelForGrain, [&output](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+					output[i] = work(i);
+			});
+
+			return secondsSince(start);
+		}
+
+		double benchmarkNestedJobs(std::atomic<uint64_t>& sink)
+		{
+			auto start = std::chrono::steady_clock::now();
+
+			JobCounter parents;
+			for (uint32_t p = 0; p < s_NestedParents; p++)
+			{
+				JobSystem::run([p, &sink]()
+				{
+					JobCounter children;
+					for (uint32_t c = 0; c < s_NestedChildren; c++)
+						JobSystem::run([p, c, &sink]() { sink.fetch_add((uint64_t)work(p * s_NestedChildren + c), std::memory_order_relaxed); }, &children);
+
+					JobSystem::wait(children);
+				}, &parents);
+			}
+			JobSystem::wait(parents);
+
+			return secondsSince(start);
+		}
+
+	}
+
+	void runJobSystemBenchmark()
+	{
+		// the calling thread is worker 0, so WorkerCount + 1 threads execute jobs
+		uint32_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+
+		std::vector<uint32_t> threadCounts;
+		for (uint32_t threads = 1; threads < maxThreads; threads *= 2)
+			threadCounts.push_back(threads);
+		threadCounts.push_back(maxThreads);
+
+		std::vector<float> output(s_ParallelForItems);
+		std::atomic<uint64_t> sink = 0;
+
+		const double nestedJobs = (double)s_NestedParents * (s_NestedChildren + 1);
+
+		std::printf("JobSystem scaling (best of %d, 1i = jobs run inline without workers)\n", s_Repetitions);
+		std::printf("%8s %18s %8s %18s %8s\n", "threads", "parallelFor Mitem/s", "speedup", "nested Mjob/s", "speedup");
+
+		double baseParallelFor = 0.0;
+		double baseNested = 0.0;
+
+		for (uint32_t threads : threadCounts)
+		{
+			// WorkerCount 0 means one per hardware thread, so the single-threaded baseline runs jobs inline without init
+			if (threads > 1)
+			{
+				JobSystemInfo info;
+				info.WorkerCount = threads - 1;
+				JobSystem::init(info);
+			}
+
+			double parallelForSeconds = 1e30;
+			double nestedSeconds = 1e30;
+			for (int i = 0; i < s_Repetitions; i++)
+			{
+				parallelForSeconds = std::min(parallelForSeconds, benchmarkParallelFor(output));
+				nestedSeconds = std::min(nestedSeconds, benchmarkNestedJobs(sink));
+			}
+
+			if (threads > 1)
+				JobSystem::shutdown();
+
+			double parallelForRate = (double)s_ParallelForItems / parallelForSeconds / 1e6;
+			double nestedRate = nestedJobs / nestedSeconds / 1e6;
+			if (threads == threadCounts.front())
+			{
+				baseParallelFor = parallelForRate;
+				baseNested = nestedRate;
+			}
+
+			std::printf("%7u%s %18.2f %7.2fx %18.2f %7.2fx\n", threads, threads == 1 ? "i" : " ", parallelForRate, parallelForRate / baseParallelFor, nestedRate, nestedRate / baseNested);
+		}
+
+		// keeps the work from being optimized away
+		std::printf("(checksum %.1f %llu)\n\n", output[output.size() / 2], (unsigned long long)sink.load());
+	}
+
+}
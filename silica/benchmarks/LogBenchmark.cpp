@@ -0,0 +1,142 @@
+#include "Benchmarks.h"
+
+#include "Core/Log.h"
+
+#include <cstdio>
+#include <ctime>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+
+namespace silica::benchmarks {
+
+	namespace {
+
+		constexpr const char* s_Format = "%c[%H:%M:%S] %m%c";
+		constexpr const char* s_Color = "\033[1;34m";
+		constexpr const char* s_Message = "Pipeline library: 412 hits, 9 misses, 181.25 ms spent compiling";
+		constexpr int s_FormatIterations = 2000000;
+		constexpr int s_LoggerIterations = 500000;
+
+		// discards everything, so only the logger's own cost is measured
+		class NullBuffer : public std::streambuf
+		{
+		protected:
+			int overflow(int c) override { return c; }
+			std::streamsize xsputn(const char*, std::streamsize count) override { return count; }
+		};
+
+		// the formatter before format strings were compiled: reparsed per message, written through an ostringstream
+		std::string formatBaseline(const std::string& message, const std::string& formatString, const std::string& colorCode, std::chrono::system_clock::time_point time)
+		{
+			auto timeNow = std::chrono::system_clock::to_time_t(time);
+			std::tm tmNow;
+#ifdef _MSC_VER
+			localtime_s(&tmNow, &timeNow);
+#else
+			localtime_r(&timeNow, &tmNow);
+#endif
+
+			bool color = false;
+
+			std::ostringstream output;
+			for (size_t i = 0; i < formatString.size(); ++i)
+			{
+				if (formatString[i] == '%' && i + 1 < formatString.size())
+				{
+					switch (formatString[i + 1])
+					{
+					case 'H': output << std::setw(2) << std::setfill('0') << tmNow.tm_hour; break;
+					case 'M': output << std::setw(2) << std::setfill('0') << tmNow.tm_min; break;
+					case 'S': output << std::setw(2) << std::setfill('0') << tmNow.tm_sec; break;
+					case 'm': output << message; break;
+					case 'c':
+						if (!color)
+							output << colorCode;
+						else if (!colorCode.empty())
+							output << "\033[0m";
+						color = !color;
+						break;
+					default: output << '%' << formatString[i + 1]; break;
+					}
+					i++;
+				}
+				else
+					output << formatString[i];
+			}
+			return output.str();
+		}
+
+		void report(const char* name, int count, double seconds)
+		{
+			std::printf("%-32s %10.2f M msg/s\n", name, (double)count / seconds / 1e6);
+		}
+
+	}
+
+	void runLogBenchmark()
+	{
+		std::printf("Logging throughput, format \"%s\", single thread\n", s_Format);
+
+		const std::string format = s_Format;
+		const std::string color = s_Color;
+		const std::string message = s_Message;
+		size_t checksum = 0;
+
+		{
+			auto start = std::chrono::steady_clock::now();
+			for (int i = 0; i < s_FormatIterations; i++)
+				checksum += formatBaseline(message, format, color, std::chrono::system_clock::now()).size();
+			report("baseline formatter", s_FormatIterations, secondsSince(start));
+		}
+
+		{
+			LogFormatter formatter(format);
+			std::string out;
+
+			auto start = std::chrono::steady_clock::now();
+			for (int i = 0; i < s_FormatIterations; i++)
+			{
+				LogRecord record;
+				record.Message = message;
+				record.Color = color;
+				record.Time = std::chrono::system_clock::now();
+
+				out.clear();
+				formatter.format(out, record);
+				checksum += out.size();
+			}
+			report("compiled formatter", s_FormatIterations, secondsSince(start));
+		}
+
+		NullBuffer nullBuffer;
+		std::ostream nullStream(&nullBuffer);
+		Logger::setupLog({ &nullStream }, {}, format);
+
+		{
+			auto start = std::chrono::steady_clock::now();
+			for (int i = 0; i < s_LoggerIterations; i++)
+				SIL_INFO("Pipeline library: {} hits, {} misses, {:.2f} ms spent compiling", i, 9, 181.25);
+			Logger::flush();
+			report("SIL_INFO, synchronous", s_LoggerIterations, secondsSince(start));
+		}
+
+		{
+			Logger::enableAsync();
+
+			auto start = std::chrono::steady_clock::now();
+			for (int i = 0; i < s_LoggerIterations; i++)
+				SIL_INFO("Pipeline library: {} hits, {} misses, {:.2f} ms spent compiling", i, 9, 181.25);
+			double enqueueSeconds = secondsSince(start);
+
+			Logger::disableAsync();
+			report("SIL_INFO, async (enqueue)", s_LoggerIterations, enqueueSeconds);
+			report("SIL_INFO, async (drained)", s_LoggerIterations, secondsSince(start));
+		}
+
+		std::printf("(checksum %zu, dropped %llu)\n\n", checksum, (unsigned long long)Logger::getDroppedMessageCount());
+	}
+
+}
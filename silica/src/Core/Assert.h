@@ -10,10 +10,10 @@
 #endif
 
 #ifdef SIL_DEBUG
-#define SIL_ASSERT(x, msg, ...) { if (!(x)) { SIL_ERROR("[Assertion failed, {}:{}] " msg, __FILE__, __LINE__, ##__VA_ARGS__); SIL_DEBUGBREAK(); } }
+#define SIL_ASSERT(x, msg, ...) { if (!(x)) { SIL_ERROR("[Assertion failed, {}:{}] " msg, __FILE__, __LINE__, ##__VA_ARGS__); ::silica::Logger::flush(); SIL_DEBUGBREAK(); } }
 
-#define SIL_ASSERT_OR_WARN(x, msg, ...) { if (!(x)) { SIL_ERROR("[Assertion failed, {}:{}] " msg, __FILE__, __LINE__, ##__VA_ARGS__); SIL_DEBUGBREAK(); } }
-#define SIL_ASSERT_OR_ERROR(x, msg, ...) { if (!(x)) { SIL_ERROR("[Assertion failed, {}:{}] " msg, __FILE__, __LINE__, ##__VA_ARGS__); SIL_DEBUGBREAK(); } }
+#define SIL_ASSERT_OR_WARN(x, msg, ...) { if (!(x)) { SIL_ERROR("[Assertion failed, {}:{}] " msg, __FILE__, __LINE__, ##__VA_ARGS__); ::silica::Logger::flush(); SIL_DEBUGBREAK(); } }
+#define SIL_ASSERT_OR_ERROR(x, msg, ...) { if (!(x)) { SIL_ERROR("[Assertion failed, {}:{}] " msg, __FILE__, __LINE__, ##__VA_ARGS__); ::silica::Logger::flush(); SIL_DEBUGBREAK(); } }
 #else
 #define SIL_ASSERT(...)
 
@@ -0,0 +1,317 @@
+#include "JobSystem.h"
+
+#include "WorkStealingDeque.h"
+#include "Profiler.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace silica {
+
+	struct Job
+	{
+		JobFunction Function;
+		JobCounter* Counter = nullptr;
+	};
+
+	struct JobSystemState
+	{
+		// index 0 belongs to the thread that called init
+		std::vector<std::unique_ptr<WorkStealingDeque<Job*>>> Deques;
+		std::vector<std::thread> Workers;
+
+		// jobs scheduled from threads that are not part of the job system
+		std::mutex InjectedMutex;
+		std::deque<Job*> Injected;
+		std::atomic<bool> HasInjected = false;
+
+		std::atomic<bool> Running = false;
+		std::atomic<uint32_t> WakeEpoch = 0;
+		std::atomic<uint32_t> Sleepers = 0;
+	};
+
+	static JobSystemState& getState()
+	{
+		static JobSystemState state;
+		return state;
+	}
+
+	static constexpr uint32_t s_InvalidThreadIndex = ~0u;
+	static thread_local uint32_t s_ThreadIndex = s_InvalidThreadIndex;
+
+	namespace utils {
+
+		static uint32_t nextRandom()
+		{
+			thread_local uint32_t state = 0x9E3779B9u ^ (uint32_t)std::hash<std::thread::id>{}(std::this_thread::get_id());
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			return state;
+		}
+
+	}
+
+	void JobSystem::init(const JobSystemInfo& info)
+	{
+		auto& state = getState();
+		if (state.Running.load(std::memory_order_relaxed))
+			return;
+
+		uint32_t workerCount = info.WorkerCount;
+		if (workerCount == 0)
+			workerCount = std::max(1u, std::thread::hardware_concurrency()) - 1;
+
+		state.Deques.clear();
+		for (uint32_t i = 0; i < workerCount + 1; i++)
+			state.Deques.push_back(std::make_unique<WorkStealingDeque<Job*>>(info.DequeCapacity));
+
+		s_ThreadIndex = 0;
+		state.Running.store(true, std::memory_order_release);
+
+		for (uint32_t i = 1; i <= workerCount; i++)
+			state.Workers.emplace_back(workerLoop, i);
+
+		SIL_DEBUG_LOG("Job system started with {} worker threads", workerCount);
+	}
+
+	void JobSystem::shutdown()
+	{
+		auto& state = getState();
+		if (!state.Running.exchange(false))
+			return;
+
+		state.WakeEpoch.fetch_add(1);
+		state.WakeEpoch.notify_all();
+
+		for (std::thread& worker : state.Workers)
+			worker.join();
+		state.Workers.clear();
+
+		// anything still queued runs on the calling thread so counters and continuations complete
+		while (Job* job = findJob(s_ThreadIndex))
+			execute(job);
+
+		state.Deques.clear();
+		s_ThreadIndex = s_InvalidThreadIndex;
+	}
+
+	uint32_t JobSystem::getThreadCount()
+	{
+		return std::max<uint32_t>(1, (uint32_t)getState().Deques.size());
+	}
+
+	bool JobSystem::isInitialized()
+	{
+		return getState().Running.load(std::memory_order_acquire);
+	}
+
+	void JobSystem::run(JobFunction function, JobCounter* counter)
+	{
+		if (counter)
+			counter->m_Pending.fetch_add(1, std::memory_order_relaxed);
+
+		Job* job = new Job{ std::move(function), counter };
+
+		if (!isInitialized())
+		{
+			execute(job);
+			return;
+		}
+
+		schedule(job);
+	}
+
+	void JobSystem::runAfter(JobCounter& dependency, JobFunction function, JobCounter* counter)
+	{
+		if (counter)
+			counter->m_Pending.fetch_add(1, std::memory_order_relaxed);
+
+		Job* job = new Job{ std::move(function), counter };
+
+		{
+			std::lock_guard<std::mutex> lock(dependency.m_Mutex);
+			if (dependency.m_Pending.load(std::memory_order_acquire) != 0)
+			{
+				dependency.m_Continuations.push_back(job);
+				return;
+			}
+		}
+
+		if (!isInitialized())
+			execute(job);
+		else
+			schedule(job);
+	}
+
+	void JobSystem::wait(JobCounter& counter)
+	{
+		uint32_t threadIndex = s_ThreadIndex;
+
+		while (!counter.isDone())
+		{
+			if (Job* job = findJob(threadIndex))
+				execute(job);
+			else
+				std::this_thread::yield();
+		}
+
+		// the job that reached zero still holds the lock until it has taken the continuations
+		std::lock_guard<std::mutex> lock(counter.m_Mutex);
+	}
+
+	void JobSystem::parallelFor(size_t begin, size_t end, size_t grainSize, const std::function<void(size_t, size_t)>& function)
+	{
+		if (end <= begin)
+			return;
+
+		size_t count = end - begin;
+		if (grainSize == 0)
+			grainSize = std::max<size_t>(1, count / ((size_t)getThreadCount() * 4));
+
+		if (count <= grainSize || !isInitialized())
+		{
+			function(begin, end);
+			return;
+		}
+
+		JobCounter counter;
+		for (size_t start = begin + grainSize; start < end; start += grainSize)
+		{
+			size_t chunkEnd = std::min(start + grainSize, end);
+			run([&function, start, chunkEnd]() { function(start, chunkEnd); }, &counter);
+		}
+
+		function(begin, begin + grainSize);
+		wait(counter);
+	}
+
+	void JobSystem::schedule(Job* job)
+	{
+		auto& state = getState();
+
+		uint32_t threadIndex = s_ThreadIndex;
+		if (threadIndex != s_InvalidThreadIndex)
+		{
+			state.Deques[threadIndex]->push(job);
+		}
+		else
+		{
+			std::lock_guard<std::mutex> lock(state.InjectedMutex);
+			state.Injected.push_back(job);
+			state.HasInjected.store(true, std::memory_order_release);
+		}
+
+		// pairs with the sleeper count / epoch sequence in workerLoop so a wake-up is never lost
+		state.WakeEpoch.fetch_add(1);
+		if (state.Sleepers.load() > 0)
+			state.WakeEpoch.notify_one();
+	}
+
+	void JobSystem::execute(Job* job)
+	{
+		job->Function();
+
+		JobCounter* counter = job->Counter;
+		delete job;
+
+		if (!counter)
+			return;
+
+		// the counter may be destroyed as soon as a waiter sees zero, so it is not touched after the unlock
+		std::vector<Job*> continuations;
+		{
+			std::lock_guard<std::mutex> lock(counter->m_Mutex);
+			if (counter->m_Pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				continuations.swap(counter->m_Continuations);
+		}
+
+		for (Job* continuation : continuations)
+		{
+			if (isInitialized())
+				schedule(continuation);
+			else
+				execute(continuation);
+		}
+	}
+
+	Job* JobSystem::findJob(uint32_t threadIndex)
+	{
+		auto& state = getState();
+		Job* job = nullptr;
+
+		if (threadIndex != s_InvalidThreadIndex && state.Deques[threadIndex]->pop(job))
+			return job;
+
+		if (state.HasInjected.load(std::memory_order_acquire))
+		{
+			std::lock_guard<std::mutex> lock(state.InjectedMutex);
+			if (!state.Injected.empty())
+			{
+				job = state.Injected.front();
+				state.Injected.pop_front();
+				state.HasInjected.store(!state.Injected.empty(), std::memory_order_release);
+				return job;
+			}
+		}
+
+		uint32_t dequeCount = (uint32_t)state.Deques.size();
+		uint32_t start = utils::nextRandom();
+
+		for (uint32_t i = 0; i < dequeCount; i++)
+		{
+			uint32_t victim = (start + i) % dequeCount;
+			if (victim != threadIndex && state.Deques[victim]->steal(job))
+				return job;
+		}
+
+		return nullptr;
+	}
+
+	void JobSystem::workerLoop(uint32_t threadIndex)
+	{
+		s_ThreadIndex = threadIndex;
+		SIL_PROFILE_THREAD("Worker " + std::to_string(threadIndex));
+
+		auto& state = getState();
+		uint32_t idleSpins = 0;
+
+		while (state.Running.load(std::memory_order_acquire))
+		{
+			if (Job* job = findJob(threadIndex))
+			{
+				execute(job);
+				idleSpins = 0;
+				continue;
+			}
+
+			if (++idleSpins < 64)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+
+			state.Sleepers.fetch_add(1);
+			uint32_t epoch = state.WakeEpoch.load();
+
+			if (Job* job = findJob(threadIndex))
+			{
+				state.Sleepers.fetch_sub(1);
+				execute(job);
+				idleSpins = 0;
+				continue;
+			}
+
+			if (state.Running.load(std::memory_order_acquire))
+				state.WakeEpoch.wait(epoch);
+
+			state.Sleepers.fetch_sub(1);
+			idleSpins = 0;
+		}
+	}
+
+}
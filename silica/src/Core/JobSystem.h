@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace silica {
+
+	struct Job;
+
+	// Counts outstanding jobs. Jobs started with a counter increment it and
+	// decrement it when they finish; continuations run once it reaches zero.
+	class JobCounter
+	{
+	public:
+		JobCounter() = default;
+		JobCounter(const JobCounter&) = delete;
+		JobCounter& operator=(const JobCounter&) = delete;
+
+		bool isDone() const { return m_Pending.load(std::memory_order_acquire) == 0; }
+	private:
+		std::atomic<uint32_t> m_Pending = 0;
+
+		std::mutex m_Mutex;
+		std::vector<Job*> m_Continuations;
+
+		friend class JobSystem;
+	};
+
+	using JobFunction = std::function<void()>;
+
+	struct JobSystemInfo
+	{
+		// 0 uses one worker per hardware thread besides the calling thread
+		uint32_t WorkerCount = 0;
+		size_t DequeCapacity = 4096;
+	};
+
+	class JobSystem
+	{
+	public:
+		// the calling thread becomes worker 0 and executes jobs whenever it waits
+		static void init(const JobSystemInfo& info = {});
+		static void shutdown();
+
+		// includes the thread that called init
+		static uint32_t getThreadCount();
+		static bool isInitialized();
+
+		static void run(JobFunction function, JobCounter* counter = nullptr);
+		// schedules function once dependency reaches zero, immediately if it already has
+		static void runAfter(JobCounter& dependency, JobFunction function, JobCounter* counter = nullptr);
+
+		// executes other jobs until counter reaches zero; the counter may be destroyed once this returns
+		static void wait(JobCounter& counter);
+
+		// calls function(begin, end) over subranges of at most grainSize; 0 picks a grain from the thread count
+		static void parallelFor(size_t begin, size_t end, size_t grainSize, const std::function<void(size_t, size_t)>& function);
+	private:
+		static void schedule(Job* job);
+		static void execute(Job* job);
+		static Job* findJob(uint32_t threadIndex);
+		static void workerLoop(uint32_t threadIndex);
+	};
+
+}
@@ -1,71 +1,355 @@
 #include "Log.h"
 
+#include "MPSCRingBuffer.h"
+
 #include <chrono>
+#include <ctime>
+#include <limits>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
 
 namespace silica {
 
-	void LogConfig::addFileOutput(const std::string& filename)
+	struct LogEntry
+	{
+		LogLevel Level = LogLevel::Info;
+		const char* Color = "";
+		std::string Message;
+		std::chrono::system_clock::time_point Time;
+		uint32_t ThreadID = 0;
+	};
+
+	class AsyncLogWorker
+	{
+	public:
+		AsyncLogWorker(const AsyncLogInfo& info)
+			: m_Info(info), m_Queue(info.Capacity)
+		{
+			m_Thread = std::thread([this]() { run(); });
+		}
+
+		~AsyncLogWorker()
+		{
+			m_Running.store(false, std::memory_order_release);
+			wake();
+			m_Thread.join();
+		}
+
+		void push(LogEntry&& entry)
+		{
+			if (!m_Queue.tryPush(std::move(entry)))
+			{
+				switch (m_Info.OverflowPolicy)
+				{
+				case LogOverflowPolicy::Block:
+					wake();
+					while (!m_Queue.tryPush(std::move(entry)))
+						std::this_thread::yield();
+					break;
+				case LogOverflowPolicy::Drop:
+					return;
+				case LogOverflowPolicy::DropAndCount:
+					m_Dropped.fetch_add(1, std::memory_order_relaxed);
+					return;
+				}
+			}
+
+			// pairs with the fence in run() so a push is never missed by a worker about to sleep
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (m_Sleeping.load(std::memory_order_relaxed))
+				wake();
+		}
+
+		void flush()
+		{
+			uint64_t target = m_FlushEpoch.load(std::memory_order_acquire) + 1;
+			m_FlushRequested.store(true, std::memory_order_release);
+			wake();
+
+			while (m_FlushEpoch.load(std::memory_order_acquire) < target)
+				std::this_thread::yield();
+		}
+
+		uint64_t getDroppedCount() const { return m_Dropped.load(std::memory_order_relaxed); }
+	private:
+		void wake()
+		{
+			std::lock_guard<std::mutex> lock(m_WakeMutex);
+			m_WakeCondition.notify_one();
+		}
+
+		void run()
+		{
+			using clock = std::chrono::steady_clock;
+
+			const auto flushInterval = std::chrono::milliseconds(m_Info.FlushIntervalMs);
+			auto lastFlush = clock::now();
+			uint64_t reportedDrops = 0;
+			bool dirty = false;
+
+			LogEntry entry;
+			for (;;)
+			{
+				bool running = m_Running.load(std::memory_order_acquire);
+				bool flushRequested = m_FlushRequested.exchange(false, std::memory_order_acq_rel);
+
+				while (m_Queue.tryPop(entry))
+				{
+					write(entry);
+					dirty = true;
+				}
+
+				uint64_t dropped = m_Dropped.load(std::memory_order_relaxed);
+				if (dropped != reportedDrops)
+				{
+					LogEntry report;
+					report.Level = LogLevel::Warn;
+					report.Color = "\033[1;33m";
+					report.Message = std::format("[Logger] {} messages dropped, log queue full", dropped - reportedDrops);
+					report.Time = std::chrono::system_clock::now();
+					report.ThreadID = Logger::getCurrentThreadID();
+					write(report);
+
+					reportedDrops = dropped;
+					dirty = true;
+				}
+
+				if (dirty && (flushRequested || !running || clock::now() - lastFlush >= flushInterval))
+				{
+					for (const auto& output : LogConfig::instance().getOutputs())
+						output.Stream->flush();
+
+					lastFlush = clock::now();
+					dirty = false;
+				}
+
+				if (flushRequested)
+					m_FlushEpoch.fetch_add(1, std::memory_order_acq_rel);
+
+				if (!running)
+					break;
+
+				std::unique_lock<std::mutex> lock(m_WakeMutex);
+				m_Sleeping.store(true, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+
+				if (m_Queue.isEmpty() && !m_FlushRequested.load(std::memory_order_acquire) && m_Running.load(std::memory_order_acquire))
+					m_WakeCondition.wait_for(lock, dirty ? flushInterval : std::chrono::milliseconds(1000));
+
+				m_Sleeping.store(false, std::memory_order_relaxed);
+			}
+		}
+
+		void write(const LogEntry& entry)
+		{
+			const auto& config = LogConfig::instance();
+
+			m_Colored.clear();
+			m_Plain.clear();
+
+			for (const auto& output : config.getOutputs())
+			{
+				if (entry.Level < output.MinLevel)
+					continue;
+
+				if (output.IsFile)
+				{
+					if (m_Plain.empty())
+					{
+						config.getFormatter().format(m_Plain, { entry.Message, "", entry.Time, entry.ThreadID });
+						m_Plain += '\n';
+					}
+
+					output.Stream->write(m_Plain.data(), (std::streamsize)m_Plain.size());
+				}
+				else
+				{
+					if (m_Colored.empty())
+					{
+						config.getFormatter().format(m_Colored, { entry.Message, entry.Color, entry.Time, entry.ThreadID });
+						m_Colored += "\033[0m\n";
+					}
+
+					output.Stream->write(m_Colored.data(), (std::streamsize)m_Colored.size());
+				}
+			}
+		}
+	private:
+		AsyncLogInfo m_Info;
+		MPSCRingBuffer<LogEntry> m_Queue;
+
+		std::string m_Colored;
+		std::string m_Plain;
+
+		std::thread m_Thread;
+		std::atomic<bool> m_Running = true;
+
+		std::mutex m_WakeMutex;
+		std::condition_variable m_WakeCondition;
+		std::atomic<bool> m_Sleeping = false;
+
+		std::atomic<bool> m_FlushRequested = false;
+		std::atomic<uint64_t> m_FlushEpoch = 0;
+		std::atomic<uint64_t> m_Dropped = 0;
+	};
+
+	static std::unique_ptr<AsyncLogWorker>& asyncWorkerStorage()
+	{
+		static std::unique_ptr<AsyncLogWorker> worker;
+		return worker;
+	}
+
+	static std::atomic<AsyncLogWorker*> s_AsyncWorker = nullptr;
+
+	void LogConfig::addFileOutput(const std::string& filename, LogLevel minLevel)
 	{
 		auto fs = std::make_unique<std::ofstream>(filename, std::ios::app);
 		if (fs->is_open())
 		{
-			m_Outputs.push_back(fs.get());
+			m_Outputs.push_back({ fs.get(), true, minLevel });
 			m_FileStreams.push_back(std::move(fs));
+			updateMinLevel();
+		}
+	}
+
+	void LogConfig::setOutputLevel(const std::ostream& os, LogLevel minLevel)
+	{
+		for (auto& output : m_Outputs)
+		{
+			if (output.Stream == &os)
+				output.MinLevel = minLevel;
+		}
+
+		updateMinLevel();
+	}
+
+	void LogConfig::updateMinLevel()
+	{
+		uint8_t minLevel = (uint8_t)LogLevel::Off;
+		for (const auto& output : m_Outputs)
+			minLevel = std::min(minLevel, (uint8_t)output.MinLevel);
+
+		m_MinLevel.store(minLevel, std::memory_order_relaxed);
+	}
+
+	namespace utils {
+
+		static void appendDigits(std::string& out, uint32_t value, uint32_t width)
+		{
+			char digits[10];
+			for (uint32_t i = width; i > 0; i--)
+			{
+				digits[i - 1] = char('0' + value % 10);
+				value /= 10;
+			}
+			out.append(digits, width);
+		}
+
+	}
+
+	void LogFormatter::compile(const std::string& formatString)
+	{
+		m_Tokens.clear();
+		m_Literals.clear();
+		m_UsesTime = false;
+
+		auto addLiteral = [this](const char* text, size_t length)
+		{
+			if (!m_Tokens.empty() && m_Tokens.back().Type == TokenType::Literal)
+				m_Tokens.back().Length += (uint32_t)length;
+			else
+				m_Tokens.push_back({ TokenType::Literal, (uint32_t)m_Literals.size(), (uint32_t)length });
+
+			m_Literals.append(text, length);
+		};
+
+		bool color = false;
+
+		for (size_t i = 0; i < formatString.size(); ++i)
+		{
+			if (formatString[i] != '%' || i + 1 >= formatString.size())
+			{
+				addLiteral(&formatString[i], 1);
+				continue;
+			}
+
+			switch (formatString[++i])
+			{
+			case 'H': m_Tokens.push_back({ TokenType::Hour }); m_UsesTime = true; break;
+			case 'M': m_Tokens.push_back({ TokenType::Minute }); m_UsesTime = true; break;
+			case 'S': m_Tokens.push_back({ TokenType::Second }); m_UsesTime = true; break;
+			case 'e': m_Tokens.push_back({ TokenType::Milliseconds }); break;
+			case 'f': m_Tokens.push_back({ TokenType::Microseconds }); break;
+			case 't': m_Tokens.push_back({ TokenType::ThreadID }); break;
+			case 'm': m_Tokens.push_back({ TokenType::Message }); break;
+			case 'c':
+				m_Tokens.push_back({ color ? TokenType::ColorEnd : TokenType::ColorBegin });
+				color = !color;
+				break;
+			default:
+				addLiteral(&formatString[i - 1], 2);
+				break;
+			}
 		}
+
+		m_SizeHint = m_Literals.size() + m_Tokens.size() * 8;
 	}
 
-	std::string LogFormatter::formatMessage(const std::string& message, const std::string& formatString, const std::string& colorCode)
+	void LogFormatter::format(std::string& out, const LogRecord& record) const
 	{
-		auto now = std::chrono::system_clock::now();
-		auto time_t_now = std::chrono::system_clock::to_time_t(now);
-		std::tm tm_now;
+		// %H:%M:%S only changes once a second, so the broken-down time is cached per thread
+		struct TimeCache
+		{
+			int64_t Second = std::numeric_limits<int64_t>::min();
+			char Text[6];
+		};
+		thread_local TimeCache cache;
+
+		int64_t micros = std::chrono::duration_cast<std::chrono::microseconds>(record.Time.time_since_epoch()).count();
+		int64_t second = micros / 1000000;
+		uint32_t subsecondMicros = (uint32_t)(micros % 1000000);
+
+		if (m_UsesTime && second != cache.Second)
+		{
+			std::time_t time = (std::time_t)second;
+			std::tm tm_now;
 #ifdef _MSC_VER
-		localtime_s(&tm_now, &time_t_now);
+			localtime_s(&tm_now, &time);
 #else
-		localtime_r(&time_t_now, &tm_now);
+			localtime_r(&time, &tm_now);
 #endif
+			cache.Second = second;
+			cache.Text[0] = char('0' + tm_now.tm_hour / 10);
+			cache.Text[1] = char('0' + tm_now.tm_hour % 10);
+			cache.Text[2] = char('0' + tm_now.tm_min / 10);
+			cache.Text[3] = char('0' + tm_now.tm_min % 10);
+			cache.Text[4] = char('0' + tm_now.tm_sec / 10);
+			cache.Text[5] = char('0' + tm_now.tm_sec % 10);
+		}
 
-		bool color = false;
+		out.reserve(out.size() + m_SizeHint + record.Message.size());
 
-		std::ostringstream output;
-		for (size_t i = 0; i < formatString.size(); ++i)
+		for (const Token& token : m_Tokens)
 		{
-			if (formatString[i] == '%' && i + 1 < formatString.size())
+			switch (token.Type)
 			{
-				switch (formatString[i + 1])
-				{
-				case 'H':
-					output << std::setw(2) << std::setfill('0') << tm_now.tm_hour;
-					break;
-				case 'M':
-					output << std::setw(2) << std::setfill('0') << tm_now.tm_min;
-					break;
-				case 'S':
-					output << std::setw(2) << std::setfill('0') << tm_now.tm_sec;
-					break;
-				case 'm':
-					output << message;
-					break;
-				case 'c':
-					if (!color)
-						output << colorCode;
-					else
-                    {
-                        if (colorCode.length() != 0)
-                            output << "\033[0m";
-                    }
-					color = !color;
-					break;
-				default:
-					output << '%' << formatString[i + 1];
-					break;
-				}
-				i++;
+			case TokenType::Literal:      out.append(m_Literals, token.Offset, token.Length); break;
+			case TokenType::Hour:         out.append(cache.Text + 0, 2); break;
+			case TokenType::Minute:       out.append(cache.Text + 2, 2); break;
+			case TokenType::Second:       out.append(cache.Text + 4, 2); break;
+			case TokenType::Milliseconds: utils::appendDigits(out, subsecondMicros / 1000, 3); break;
+			case TokenType::Microseconds: utils::appendDigits(out, subsecondMicros, 6); break;
+			case TokenType::ThreadID:     out.append(std::to_string(record.ThreadID)); break;
+			case TokenType::Message:      out.append(record.Message); break;
+			case TokenType::ColorBegin:   out.append(record.Color); break;
+			case TokenType::ColorEnd:
+				if (!record.Color.empty())
+					out.append("\033[0m");
+				break;
 			}
-			else
-				output << formatString[i];
 		}
-		return output.str();
 	}
 
 	void Logger::setupLog(const std::vector<std::ostream*>& streams, const std::vector<std::string>& files, const std::string& format)
@@ -82,27 +366,96 @@ namespace silica {
 		config.setFormat(format);
 	}
 
-	void Logger::log(const std::string& color, const std::string& msg)
+	void Logger::enableAsync(const AsyncLogInfo& info)
 	{
+		// the config must outlive the worker, which drains into it on shutdown
+		LogConfig::instance();
+
+		disableAsync();
+
+		auto& worker = asyncWorkerStorage();
+		worker = std::make_unique<AsyncLogWorker>(info);
+		s_AsyncWorker.store(worker.get(), std::memory_order_release);
+	}
+
+	void Logger::disableAsync()
+	{
+		s_AsyncWorker.store(nullptr, std::memory_order_release);
+		asyncWorkerStorage().reset();
+	}
+
+	void Logger::flush()
+	{
+		if (AsyncLogWorker* worker = s_AsyncWorker.load(std::memory_order_acquire))
+		{
+			worker->flush();
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(s_LogMutex);
+		for (const auto& output : LogConfig::instance().getOutputs())
+			output.Stream->flush();
+	}
+
+	uint32_t Logger::getCurrentThreadID()
+	{
+		static std::atomic<uint32_t> s_NextThreadID = 0;
+		thread_local uint32_t threadID = s_NextThreadID.fetch_add(1, std::memory_order_relaxed);
+		return threadID;
+	}
+
+	uint64_t Logger::getDroppedMessageCount()
+	{
+		if (AsyncLogWorker* worker = s_AsyncWorker.load(std::memory_order_acquire))
+			return worker->getDroppedCount();
+
+		return 0;
+	}
+
+	void Logger::log(LogLevel level, const char* color, std::string&& msg)
+	{
+		if (AsyncLogWorker* worker = s_AsyncWorker.load(std::memory_order_acquire))
+		{
+			worker->push({ level, color, std::move(msg), std::chrono::system_clock::now(), getCurrentThreadID() });
+			return;
+		}
+
+		LogRecord record = { msg, color, std::chrono::system_clock::now(), getCurrentThreadID() };
+
 		std::lock_guard<std::mutex> lock(s_LogMutex);
 		const auto& config = LogConfig::instance();
-		
-		for (auto* out : config.getOutputs())
-		{
-            bool isFile = dynamic_cast<std::ofstream*>(out) != nullptr;
-            
-            std::string formatted;
-            if (isFile)
-                formatted = LogFormatter::formatMessage(msg, config.getFormat(), "");
-            else
-                formatted = LogFormatter::formatMessage(msg, config.getFormat(), color);
-            
-			(*out) << formatted;
-            
-            if (!isFile)
-                (*out) << "\033[0m";
-
-            (*out) << std::endl;
+
+		thread_local std::string colored;
+		thread_local std::string plain;
+		colored.clear();
+		plain.clear();
+
+		for (const auto& output : config.getOutputs())
+		{
+			if (level < output.MinLevel)
+				continue;
+
+			auto& out = *output.Stream;
+
+			if (output.IsFile)
+			{
+				if (plain.empty())
+					config.getFormatter().format(plain, { record.Message, "", record.Time, record.ThreadID });
+
+				out << plain;
+			}
+			else
+			{
+				if (colored.empty())
+				{
+					config.getFormatter().format(colored, record);
+					colored += "\033[0m";
+				}
+
+				out << colored;
+			}
+
+			out << std::endl;
 		}
 	}
 
@@ -3,13 +3,106 @@
 #include <iostream>
 #include <ostream>
 #include <string>
+#include <string_view>
 #include <format>
 #include <vector>
 #include <fstream>
 #include <mutex>
+#include <chrono>
+#include <memory>
+#include <cstdint>
+#include <atomic>
+
+#define SIL_LOG_LEVEL_TRACE 0
+#define SIL_LOG_LEVEL_DEBUG 1
+#define SIL_LOG_LEVEL_INFO 2
+#define SIL_LOG_LEVEL_WARN 3
+#define SIL_LOG_LEVEL_ERROR 4
+#define SIL_LOG_LEVEL_OFF 5
+
+// log macros below this level compile to nothing and never evaluate their arguments
+#ifndef SIL_LOG_MIN_LEVEL
+#define SIL_LOG_MIN_LEVEL SIL_LOG_LEVEL_TRACE
+#endif
 
 namespace silica {
 
+	enum class LogLevel : uint8_t
+	{
+		Trace = SIL_LOG_LEVEL_TRACE,
+		Debug = SIL_LOG_LEVEL_DEBUG,
+		Info = SIL_LOG_LEVEL_INFO,
+		Warn = SIL_LOG_LEVEL_WARN,
+		Error = SIL_LOG_LEVEL_ERROR,
+		Off = SIL_LOG_LEVEL_OFF
+	};
+
+	enum class LogOverflowPolicy
+	{
+		Block = 0,
+		Drop,
+		DropAndCount
+	};
+
+	struct AsyncLogInfo
+	{
+		size_t Capacity = 8192;
+		LogOverflowPolicy OverflowPolicy = LogOverflowPolicy::DropAndCount;
+		uint32_t FlushIntervalMs = 100;
+	};
+
+	struct LogOutput
+	{
+		std::ostream* Stream = nullptr;
+		bool IsFile = false;
+		LogLevel MinLevel = LogLevel::Trace;
+	};
+
+	struct LogRecord
+	{
+		std::string_view Message;
+		std::string_view Color;
+		std::chrono::system_clock::time_point Time;
+		uint32_t ThreadID = 0;
+	};
+
+	class LogFormatter
+	{
+	public:
+		LogFormatter() = default;
+		explicit LogFormatter(const std::string& formatString) { compile(formatString); }
+
+		// %H/%M/%S time, %e milliseconds, %f microseconds, %t thread id, %m message, %c toggles colour
+		void compile(const std::string& formatString);
+		void format(std::string& out, const LogRecord& record) const;
+	private:
+		enum class TokenType : uint8_t
+		{
+			Literal = 0,
+			Hour,
+			Minute,
+			Second,
+			Milliseconds,
+			Microseconds,
+			ThreadID,
+			Message,
+			ColorBegin,
+			ColorEnd
+		};
+
+		struct Token
+		{
+			TokenType Type = TokenType::Literal;
+			uint32_t Offset = 0;
+			uint32_t Length = 0;
+		};
+
+		std::vector<Token> m_Tokens;
+		std::string m_Literals;
+		size_t m_SizeHint = 0;
+		bool m_UsesTime = false;
+	};
+
 	class LogConfig
 	{
 	public:
@@ -20,55 +113,91 @@ namespace silica {
 		}
 
 		const std::string& getFormat() const { return m_Format; }
-		void setFormat(const std::string& fmt) { m_Format = fmt; }
+		const LogFormatter& getFormatter() const { return m_Formatter; }
+		void setFormat(const std::string& fmt)
+		{
+			m_Format = fmt;
+			m_Formatter.compile(fmt);
+		}
 
 		void clearOutputs()
 		{
 			m_Outputs.clear();
 			m_FileStreams.clear();
+			updateMinLevel();
 		}
 
-		void addOutput(std::ostream& os) { m_Outputs.push_back(&os); }
-		const std::vector<std::ostream*> getOutputs() const { return m_Outputs; }
+		void addOutput(std::ostream& os, LogLevel minLevel = LogLevel::Trace)
+		{
+			m_Outputs.push_back({ &os, false, minLevel });
+			updateMinLevel();
+		}
 
-		void addFileOutput(const std::string& filename);
+		void addFileOutput(const std::string& filename, LogLevel minLevel = LogLevel::Trace);
+		void setOutputLevel(const std::ostream& os, LogLevel minLevel);
+
+		const std::vector<LogOutput>& getOutputs() const { return m_Outputs; }
+
+		// lowest level any output accepts, checked before a message is formatted
+		bool isLevelEnabled(LogLevel level) const { return (uint8_t)level >= m_MinLevel.load(std::memory_order_relaxed); }
+	private:
+		void updateMinLevel();
 	private:
-		std::vector<std::ostream*> m_Outputs;
+		std::vector<LogOutput> m_Outputs;
+		std::atomic<uint8_t> m_MinLevel = (uint8_t)LogLevel::Off;
 		std::string m_Format = "%c[%H:%M:%S]%m%c";
+		LogFormatter m_Formatter{ m_Format };
 
 		std::vector<std::unique_ptr<std::ofstream>> m_FileStreams;
 	};
 
-	class LogFormatter
-	{
-	public:
-		static std::string formatMessage(const std::string& message, const std::string& formatString, const std::string& colorCode);
-	};
-
 	class Logger
 	{
 	public:
 		static void setupLog(const std::vector<std::ostream*>& streams, const std::vector<std::string>& files, const std::string& format);
 
+		// moves formatting and writing onto a background thread; call before other threads start logging
+		static void enableAsync(const AsyncLogInfo& info = {});
+		// drains everything queued so far and joins the background thread
+		static void disableAsync();
+		static void flush();
+
+		static uint64_t getDroppedMessageCount();
+		static uint32_t getCurrentThreadID();
+
+		static bool isEnabled(LogLevel level) { return LogConfig::instance().isLevelEnabled(level); }
+
+		template<typename... Args>
+		static void logTraceFormat(std::format_string<Args...> fmt, Args&&... args)
+		{
+			log(LogLevel::Trace, "\033[0;37m", std::format(fmt, std::forward<Args>(args)...));
+		}
+
+		template<typename... Args>
+		static void logDebugFormat(std::format_string<Args...> fmt, Args&&... args)
+		{
+			log(LogLevel::Debug, "\033[1;36m", std::format(fmt, std::forward<Args>(args)...));
+		}
+
 		template<typename... Args>
 		static void logInfoFormat(std::format_string<Args...> fmt, Args&&... args)
 		{
-			log("\033[1;34m", std::format(fmt, std::forward<Args>(args)...));
+			log(LogLevel::Info, "\033[1;34m", std::format(fmt, std::forward<Args>(args)...));
 		}
 
 		template<typename... Args>
 		static void logWarningFormat(std::format_string<Args...> fmt, Args&&... args)
 		{
-			log("\033[1;33m", std::format(fmt, std::forward<Args>(args)...));
+			log(LogLevel::Warn, "\033[1;33m", std::format(fmt, std::forward<Args>(args)...));
 		}
 
 		template<typename... Args>
 		static void logErrorFormat(std::format_string<Args...> fmt, Args&&... args)
 		{
-			log("\033[1;31m", std::format(fmt, std::forward<Args>(args)...));
+			log(LogLevel::Error, "\033[1;31m", std::format(fmt, std::forward<Args>(args)...));
 		}
 	private:
-		static void log(const std::string& color, const std::string& msg);
+		static void log(LogLevel level, const char* color, std::string&& msg);
 	private:
 		inline static std::mutex s_LogMutex;
 	};
@@ -76,6 +205,34 @@ namespace silica {
 }
 
 #define SIL_SETUP_LOG(outStreams, outFiles, format) ::silica::Logger::setupLog(outStreams, outFiles, format);
-#define SIL_INFO(msg, ...) ::silica::Logger::logInfoFormat(msg, ##__VA_ARGS__)
-#define SIL_WARN(msg, ...) ::silica::Logger::logWarningFormat(msg, ##__VA_ARGS__)
-#define SIL_ERROR(msg, ...) ::silica::Logger::logErrorFormat(msg, ##__VA_ARGS__)
+#define SIL_LOG_IF_ENABLED(level, fn, msg, ...) do { if (::silica::Logger::isEnabled(level)) ::silica::Logger::fn(msg, ##__VA_ARGS__); } while (0)
+
+#if SIL_LOG_MIN_LEVEL <= SIL_LOG_LEVEL_TRACE
+#define SIL_TRACE(msg, ...) SIL_LOG_IF_ENABLED(::silica::LogLevel::Trace, logTraceFormat, msg, ##__VA_ARGS__)
+#else
+#define SIL_TRACE(...) ((void)0)
+#endif
+
+#if SIL_LOG_MIN_LEVEL <= SIL_LOG_LEVEL_DEBUG
+#define SIL_DEBUG_LOG(msg, ...) SIL_LOG_IF_ENABLED(::silica::LogLevel::Debug, logDebugFormat, msg, ##__VA_ARGS__)
+#else
+#define SIL_DEBUG_LOG(...) ((void)0)
+#endif
+
+#if SIL_LOG_MIN_LEVEL <= SIL_LOG_LEVEL_INFO
+#define SIL_INFO(msg, ...) SIL_LOG_IF_ENABLED(::silica::LogLevel::Info, logInfoFormat, msg, ##__VA_ARGS__)
+#else
+#define SIL_INFO(...) ((void)0)
+#endif
+
+#if SIL_LOG_MIN_LEVEL <= SIL_LOG_LEVEL_WARN
+#define SIL_WARN(msg, ...) SIL_LOG_IF_ENABLED(::silica::LogLevel::Warn, logWarningFormat, msg, ##__VA_ARGS__)
+#else
+#define SIL_WARN(...) ((void)0)
+#endif
+
+#if SIL_LOG_MIN_LEVEL <= SIL_LOG_LEVEL_ERROR
+#define SIL_ERROR(msg, ...) SIL_LOG_IF_ENABLED(::silica::LogLevel::Error, logErrorFormat, msg, ##__VA_ARGS__)
+#else
+#define SIL_ERROR(...) ((void)0)
+#endif
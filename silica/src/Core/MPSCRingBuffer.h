@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+namespace silica {
+
+	// Bounded multi-producer/single-consumer queue (Vyukov). Producers claim a
+	// cell with a CAS on the enqueue position, the consumer never contends.
+	template<typename T>
+	class MPSCRingBuffer
+	{
+	public:
+		explicit MPSCRingBuffer(size_t capacity)
+		{
+			size_t size = 2;
+			while (size < capacity)
+				size <<= 1;
+
+			m_Mask = size - 1;
+			m_Cells = std::make_unique<Cell[]>(size);
+
+			for (size_t i = 0; i < size; i++)
+				m_Cells[i].Sequence.store(i, std::memory_order_relaxed);
+		}
+
+		MPSCRingBuffer(const MPSCRingBuffer&) = delete;
+		MPSCRingBuffer& operator=(const MPSCRingBuffer&) = delete;
+
+		bool tryPush(T&& value)
+		{
+			Cell* cell = nullptr;
+			size_t pos = m_EnqueuePos.load(std::memory_order_relaxed);
+
+			for (;;)
+			{
+				cell = &m_Cells[pos & m_Mask];
+				size_t sequence = cell->Sequence.load(std::memory_order_acquire);
+				intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+
+				if (diff == 0)
+				{
+					if (m_EnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+						break;
+				}
+				else if (diff < 0)
+					return false;
+				else
+					pos = m_EnqueuePos.load(std::memory_order_relaxed);
+			}
+
+			cell->Data = std::move(value);
+			cell->Sequence.store(pos + 1, std::memory_order_release);
+			return true;
+		}
+
+		// consumer thread only
+		bool tryPop(T& out)
+		{
+			Cell& cell = m_Cells[m_DequeuePos & m_Mask];
+			size_t sequence = cell.Sequence.load(std::memory_order_acquire);
+
+			if ((intptr_t)sequence - (intptr_t)(m_DequeuePos + 1) < 0)
+				return false;
+
+			out = std::move(cell.Data);
+			cell.Sequence.store(m_DequeuePos + m_Mask + 1, std::memory_order_release);
+			m_DequeuePos++;
+			return true;
+		}
+
+		// consumer thread only
+		bool isEmpty() const
+		{
+			const Cell& cell = m_Cells[m_DequeuePos & m_Mask];
+			return (intptr_t)cell.Sequence.load(std::memory_order_acquire) - (intptr_t)(m_DequeuePos + 1) < 0;
+		}
+
+		size_t capacity() const { return m_Mask + 1; }
+	private:
+		struct Cell
+		{
+			std::atomic<size_t> Sequence;
+			T Data;
+		};
+
+		std::unique_ptr<Cell[]> m_Cells;
+		size_t m_Mask = 0;
+
+		alignas(64) std::atomic<size_t> m_EnqueuePos = 0;
+		alignas(64) size_t m_DequeuePos = 0;
+	};
+
+}
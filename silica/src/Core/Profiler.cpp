@@ -0,0 +1,219 @@
+#include "Profiler.h"
+
+#include "Log.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace silica {
+
+	struct ProfileEvent
+	{
+		const char* Name;
+		int64_t StartNs;
+		int64_t EndNs;
+	};
+
+	// Append-only per-thread storage. Only the owning thread writes; the exporter
+	// reads events below the published count, so recording never takes a lock.
+	struct ProfileThreadBuffer
+	{
+		static constexpr size_t s_ChunkSize = 4096;
+		static constexpr size_t s_MaxChunks = 1024;
+
+		uint32_t ThreadID = 0;
+		std::string ThreadName;
+		std::atomic<uint64_t> Generation = 0;
+
+		std::array<std::atomic<ProfileEvent*>, s_MaxChunks> Chunks{};
+		std::atomic<size_t> Count = 0;
+
+		int64_t FrameStart = -1;
+
+		~ProfileThreadBuffer()
+		{
+			for (auto& chunk : Chunks)
+				delete[] chunk.load(std::memory_order_relaxed);
+		}
+	};
+
+	struct ProfilerState
+	{
+		std::mutex Mutex;
+		std::vector<std::unique_ptr<ProfileThreadBuffer>> Threads;
+		std::atomic<uint64_t> Generation = 0;
+		std::atomic<uint64_t> DroppedEvents = 0;
+		std::chrono::steady_clock::time_point Epoch = std::chrono::steady_clock::now();
+	};
+
+	static ProfilerState& getState()
+	{
+		static ProfilerState state;
+		return state;
+	}
+
+	static ProfileThreadBuffer& getThreadBuffer()
+	{
+		thread_local ProfileThreadBuffer* buffer = nullptr;
+		if (!buffer)
+		{
+			auto& state = getState();
+			std::lock_guard<std::mutex> lock(state.Mutex);
+
+			auto& newBuffer = state.Threads.emplace_back(std::make_unique<ProfileThreadBuffer>());
+			newBuffer->ThreadID = (uint32_t)state.Threads.size();
+			newBuffer->Generation.store(state.Generation.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			buffer = newBuffer.get();
+		}
+
+		return *buffer;
+	}
+
+	int64_t Profiler::now()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - getState().Epoch).count();
+	}
+
+	void Profiler::record(const char* name, int64_t startNs, int64_t endNs)
+	{
+		ProfileThreadBuffer& buffer = getThreadBuffer();
+
+		uint64_t generation = getState().Generation.load(std::memory_order_relaxed);
+		if (buffer.Generation.load(std::memory_order_relaxed) != generation)
+		{
+			buffer.Count.store(0, std::memory_order_release);
+			buffer.Generation.store(generation, std::memory_order_release);
+		}
+
+		size_t index = buffer.Count.load(std::memory_order_relaxed);
+		size_t chunkIndex = index / ProfileThreadBuffer::s_ChunkSize;
+
+		if (chunkIndex >= ProfileThreadBuffer::s_MaxChunks)
+		{
+			getState().DroppedEvents.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		ProfileEvent* chunk = buffer.Chunks[chunkIndex].load(std::memory_order_relaxed);
+		if (!chunk)
+		{
+			chunk = new ProfileEvent[ProfileThreadBuffer::s_ChunkSize];
+			buffer.Chunks[chunkIndex].store(chunk, std::memory_order_release);
+		}
+
+		chunk[index % ProfileThreadBuffer::s_ChunkSize] = { name, startNs, endNs };
+		buffer.Count.store(index + 1, std::memory_order_release);
+	}
+
+	void Profiler::beginFrame()
+	{
+		getThreadBuffer().FrameStart = now();
+	}
+
+	void Profiler::endFrame()
+	{
+		ProfileThreadBuffer& buffer = getThreadBuffer();
+		if (buffer.FrameStart < 0)
+			return;
+
+		record("Frame", buffer.FrameStart, now());
+		buffer.FrameStart = -1;
+	}
+
+	void Profiler::setThreadName(const std::string& name)
+	{
+		ProfileThreadBuffer& buffer = getThreadBuffer();
+
+		std::lock_guard<std::mutex> lock(getState().Mutex);
+		buffer.ThreadName = name;
+	}
+
+	void Profiler::clear()
+	{
+		getState().Generation.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	namespace utils {
+
+		static void writeJsonString(std::ofstream& out, const char* text)
+		{
+			out << '"';
+			for (const char* c = text; *c; c++)
+			{
+				if (*c == '"' || *c == '\\')
+					out << '\\';
+				out << *c;
+			}
+			out << '"';
+		}
+
+	}
+
+	bool Profiler::writeChromeTrace(const std::string& path)
+	{
+		std::ofstream out(path, std::ios::trunc);
+		if (!out.is_open())
+		{
+			SIL_ERROR("Failed to open profiler trace file '{}'", path);
+			return false;
+		}
+
+		auto& state = getState();
+		std::lock_guard<std::mutex> lock(state.Mutex);
+
+		uint64_t generation = state.Generation.load(std::memory_order_relaxed);
+		size_t eventCount = 0;
+		bool first = true;
+
+		// microseconds with nanosecond digits; the default precision turns long captures into 1.23457e+06
+		out << std::fixed << std::setprecision(3);
+		out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+		for (const auto& thread : state.Threads)
+		{
+			if (!thread->ThreadName.empty())
+			{
+				out << (first ? "" : ",") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread->ThreadID << ",\"args\":{\"name\":";
+				utils::writeJsonString(out, thread->ThreadName.c_str());
+				out << "}}";
+				first = false;
+			}
+
+			// a thread that has not recorded since the last clear() still holds stale events
+			if (thread->Generation.load(std::memory_order_acquire) != generation)
+				continue;
+
+			size_t count = thread->Count.load(std::memory_order_acquire);
+			for (size_t i = 0; i < count; i++)
+			{
+				const ProfileEvent* chunk = thread->Chunks[i / ProfileThreadBuffer::s_ChunkSize].load(std::memory_order_acquire);
+				const ProfileEvent& event = chunk[i % ProfileThreadBuffer::s_ChunkSize];
+
+				out << (first ? "" : ",") << "{\"name\":";
+				utils::writeJsonString(out, event.Name);
+				out << ",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread->ThreadID
+					<< ",\"ts\":" << (double)event.StartNs / 1000.0
+					<< ",\"dur\":" << (double)(event.EndNs - event.StartNs) / 1000.0 << "}";
+				first = false;
+			}
+
+			eventCount += count;
+		}
+
+		out << "]}";
+
+		uint64_t dropped = state.DroppedEvents.load(std::memory_order_relaxed);
+		if (dropped)
+			SIL_WARN("Profiler dropped {} events, per-thread buffers are full", dropped);
+
+		SIL_INFO("Wrote {} profiler events to '{}'", eventCount, path);
+		return true;
+	}
+
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+namespace silica {
+
+	class Profiler
+	{
+	public:
+		// names must have static storage duration (string literals, __FUNCTION__)
+		static void record(const char* name, int64_t startNs, int64_t endNs);
+		static int64_t now();
+
+		static void beginFrame();
+		static void endFrame();
+
+		static void setThreadName(const std::string& name);
+
+		// discards recorded events; each thread drops its buffer the next time it records
+		static void clear();
+		// Chrome about:tracing / Perfetto JSON
+		static bool writeChromeTrace(const std::string& path);
+	};
+
+	class ProfileScope
+	{
+	public:
+		explicit ProfileScope(const char* name)
+			: m_Name(name), m_Start(Profiler::now())
+		{
+		}
+
+		~ProfileScope()
+		{
+			Profiler::record(m_Name, m_Start, Profiler::now());
+		}
+
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+	private:
+		const char* m_Name;
+		int64_t m_Start;
+	};
+
+}
+
+#ifdef SIL_ENABLE_PROFILING
+#define SIL_PROFILE_CONCAT_IMPL(a, b) a##b
+#define SIL_PROFILE_CONCAT(a, b) SIL_PROFILE_CONCAT_IMPL(a, b)
+
+#define SIL_PROFILE_SCOPE(name) ::silica::ProfileScope SIL_PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define SIL_PROFILE_FUNCTION() SIL_PROFILE_SCOPE(__FUNCTION__)
+#define SIL_PROFILE_BEGIN_FRAME() ::silica::Profiler::beginFrame()
+#define SIL_PROFILE_END_FRAME() ::silica::Profiler::endFrame()
+#define SIL_PROFILE_THREAD(name) ::silica::Profiler::setThreadName(name)
+#define SIL_PROFILE_WRITE_TRACE(path) ::silica::Profiler::writeChromeTrace(path)
+#else
+#define SIL_PROFILE_SCOPE(name)
+#define SIL_PROFILE_FUNCTION()
+#define SIL_PROFILE_BEGIN_FRAME()
+#define SIL_PROFILE_END_FRAME()
+#define SIL_PROFILE_THREAD(name)
+#define SIL_PROFILE_WRITE_TRACE(path)
+#endif
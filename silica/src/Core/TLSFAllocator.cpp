@@ -0,0 +1,243 @@
+#include "TLSFAllocator.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace silica {
+
+	TLSFAllocator::TLSFAllocator(uint64_t capacity, uint64_t granularity)
+	{
+		reset(capacity, granularity);
+	}
+
+	void TLSFAllocator::reset(uint64_t capacity, uint64_t granularity)
+	{
+		m_Granularity = std::max<uint64_t>(1, granularity);
+		m_Capacity = capacity / m_Granularity * m_Granularity;
+		m_FreeBytes = m_Capacity;
+		m_AllocationCount = 0;
+
+		m_FirstLevelBitmap = 0;
+		for (uint32_t i = 0; i < s_FirstLevelCount; i++)
+		{
+			m_SecondLevelBitmaps[i] = 0;
+			for (uint32_t j = 0; j < s_SecondLevelCount; j++)
+				m_FreeHeads[i][j] = InvalidNode;
+		}
+
+		m_Nodes.clear();
+		m_FreeNodes.clear();
+
+		if (m_Capacity > 0)
+			insertFree(createNode(0, m_Capacity / m_Granularity));
+	}
+
+	TLSFAllocator::Allocation TLSFAllocator::allocate(uint64_t size, uint64_t alignment)
+	{
+		if (size == 0)
+			return {};
+
+		uint64_t units = (size + m_Granularity - 1) / m_Granularity;
+		alignment = std::max(alignment, m_Granularity);
+
+		// worst case padding needed to reach an aligned offset from a granularity-aligned one
+		uint64_t searchUnits = units + alignment / m_Granularity - 1;
+
+		uint32_t node = findFree(searchUnits);
+		if (node == InvalidNode)
+			return {};
+
+		removeFree(node);
+
+		uint64_t offset = m_Nodes[node].Offset;
+		uint64_t alignedOffset = (offset + alignment - 1) & ~(alignment - 1);
+		uint64_t paddingUnits = (alignedOffset - offset) / m_Granularity;
+
+		if (paddingUnits > 0)
+		{
+			uint32_t aligned = split(node, paddingUnits);
+			insertFree(node);
+			node = aligned;
+		}
+
+		if (m_Nodes[node].Size > units)
+			insertFree(split(node, units));
+
+		m_Nodes[node].Used = true;
+		m_FreeBytes -= units * m_Granularity;
+		m_AllocationCount++;
+
+		return { alignedOffset, units * m_Granularity, node };
+	}
+
+	void TLSFAllocator::free(const Allocation& allocation)
+	{
+		uint32_t node = allocation.Node;
+		if (node == InvalidNode)
+			return;
+
+		m_Nodes[node].Used = false;
+		m_FreeBytes += m_Nodes[node].Size * m_Granularity;
+		m_AllocationCount--;
+
+		uint32_t next = m_Nodes[node].NextPhysical;
+		if (next != InvalidNode && !m_Nodes[next].Used)
+		{
+			removeFree(next);
+			merge(node, next);
+		}
+
+		uint32_t prev = m_Nodes[node].PrevPhysical;
+		if (prev != InvalidNode && !m_Nodes[prev].Used)
+		{
+			removeFree(prev);
+			merge(prev, node);
+			node = prev;
+		}
+
+		insertFree(node);
+	}
+
+	void TLSFAllocator::mapping(uint64_t units, uint32_t& firstLevel, uint32_t& secondLevel)
+	{
+		// sizes below the second level count are mapped linearly into the first row
+		if (units < s_SecondLevelCount)
+		{
+			firstLevel = 0;
+			secondLevel = (uint32_t)units;
+			return;
+		}
+
+		uint32_t msb = (uint32_t)std::bit_width(units) - 1;
+		firstLevel = msb - s_SecondLevelLog2 + 1;
+		secondLevel = (uint32_t)(units >> (msb - s_SecondLevelLog2)) - s_SecondLevelCount;
+	}
+
+	uint32_t TLSFAllocator::createNode(uint64_t offset, uint64_t units)
+	{
+		uint32_t index;
+		if (!m_FreeNodes.empty())
+		{
+			index = m_FreeNodes.back();
+			m_FreeNodes.pop_back();
+		}
+		else
+		{
+			index = (uint32_t)m_Nodes.size();
+			m_Nodes.emplace_back();
+		}
+
+		m_Nodes[index] = Node{};
+		m_Nodes[index].Offset = offset;
+		m_Nodes[index].Size = units;
+		return index;
+	}
+
+	void TLSFAllocator::destroyNode(uint32_t node)
+	{
+		m_FreeNodes.push_back(node);
+	}
+
+	void TLSFAllocator::insertFree(uint32_t node)
+	{
+		uint32_t firstLevel, secondLevel;
+		mapping(m_Nodes[node].Size, firstLevel, secondLevel);
+
+		uint32_t& head = m_FreeHeads[firstLevel][secondLevel];
+		m_Nodes[node].PrevFree = InvalidNode;
+		m_Nodes[node].NextFree = head;
+		if (head != InvalidNode)
+			m_Nodes[head].PrevFree = node;
+		head = node;
+
+		m_SecondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+		m_FirstLevelBitmap |= 1ull << firstLevel;
+	}
+
+	void TLSFAllocator::removeFree(uint32_t node)
+	{
+		uint32_t firstLevel, secondLevel;
+		mapping(m_Nodes[node].Size, firstLevel, secondLevel);
+
+		Node& entry = m_Nodes[node];
+		if (entry.PrevFree != InvalidNode)
+			m_Nodes[entry.PrevFree].NextFree = entry.NextFree;
+		if (entry.NextFree != InvalidNode)
+			m_Nodes[entry.NextFree].PrevFree = entry.PrevFree;
+
+		uint32_t& head = m_FreeHeads[firstLevel][secondLevel];
+		if (head == node)
+		{
+			head = entry.NextFree;
+			if (head == InvalidNode)
+			{
+				m_SecondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+				if (m_SecondLevelBitmaps[firstLevel] == 0)
+					m_FirstLevelBitmap &= ~(1ull << firstLevel);
+			}
+		}
+
+		entry.PrevFree = InvalidNode;
+		entry.NextFree = InvalidNode;
+	}
+
+	uint32_t TLSFAllocator::findFree(uint64_t units) const
+	{
+		// round up to the next class so any block found is guaranteed to fit
+		uint64_t rounded = units;
+		if (rounded >= s_SecondLevelCount)
+			rounded += (1ull << (std::bit_width(rounded) - 1 - s_SecondLevelLog2)) - 1;
+
+		uint32_t firstLevel, secondLevel;
+		mapping(rounded, firstLevel, secondLevel);
+
+		uint32_t secondLevelMap = firstLevel < s_FirstLevelCount ? m_SecondLevelBitmaps[firstLevel] & (~0u << secondLevel) : 0;
+		if (secondLevelMap == 0)
+		{
+			uint64_t firstLevelMap = firstLevel + 1 < s_FirstLevelCount ? m_FirstLevelBitmap & (~0ull << (firstLevel + 1)) : 0;
+			if (firstLevelMap != 0)
+			{
+				firstLevel = (uint32_t)std::countr_zero(firstLevelMap);
+				secondLevelMap = m_SecondLevelBitmaps[firstLevel];
+			}
+		}
+
+		if (secondLevelMap != 0)
+			return m_FreeHeads[firstLevel][std::countr_zero(secondLevelMap)];
+
+		// the rounded class is empty, but a block in the request's own class may still be large enough
+		mapping(units, firstLevel, secondLevel);
+		for (uint32_t node = m_FreeHeads[firstLevel][secondLevel]; node != InvalidNode; node = m_Nodes[node].NextFree)
+		{
+			if (m_Nodes[node].Size >= units)
+				return node;
+		}
+
+		return InvalidNode;
+	}
+
+	uint32_t TLSFAllocator::split(uint32_t node, uint64_t units)
+	{
+		uint32_t back = createNode(m_Nodes[node].Offset + units * m_Granularity, m_Nodes[node].Size - units);
+
+		m_Nodes[node].Size = units;
+		m_Nodes[back].PrevPhysical = node;
+		m_Nodes[back].NextPhysical = m_Nodes[node].NextPhysical;
+		if (m_Nodes[node].NextPhysical != InvalidNode)
+			m_Nodes[m_Nodes[node].NextPhysical].PrevPhysical = back;
+		m_Nodes[node].NextPhysical = back;
+
+		return back;
+	}
+
+	void TLSFAllocator::merge(uint32_t node, uint32_t next)
+	{
+		m_Nodes[node].Size += m_Nodes[next].Size;
+		m_Nodes[node].NextPhysical = m_Nodes[next].NextPhysical;
+		if (m_Nodes[next].NextPhysical != InvalidNode)
+			m_Nodes[m_Nodes[next].NextPhysical].PrevPhysical = node;
+
+		destroyNode(next);
+	}
+
+}
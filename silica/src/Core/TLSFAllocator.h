@@ -0,0 +1,80 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace silica {
+
+	// Two-level segregated fit allocator over an abstract range [0, capacity). It only
+	// does the bookkeeping, so it can hand out offsets into GPU memory. Allocation and
+	// free are O(1); offsets and sizes are multiples of the granularity.
+	class TLSFAllocator
+	{
+	public:
+		static constexpr uint32_t InvalidNode = ~0u;
+
+		struct Allocation
+		{
+			uint64_t Offset = 0;
+			uint64_t Size = 0;
+			uint32_t Node = InvalidNode;
+
+			bool isValid() const { return Node != InvalidNode; }
+		};
+
+		TLSFAllocator() = default;
+		TLSFAllocator(uint64_t capacity, uint64_t granularity = 256);
+
+		void reset(uint64_t capacity, uint64_t granularity = 256);
+
+		// alignment must be a power of two; returns an invalid allocation when nothing fits
+		Allocation allocate(uint64_t size, uint64_t alignment = 1);
+		void free(const Allocation& allocation);
+
+		uint64_t getCapacity() const { return m_Capacity; }
+		uint64_t getFreeBytes() const { return m_FreeBytes; }
+		uint32_t getAllocationCount() const { return m_AllocationCount; }
+		bool isEmpty() const { return m_AllocationCount == 0; }
+	private:
+		static constexpr uint32_t s_SecondLevelLog2 = 4;
+		static constexpr uint32_t s_SecondLevelCount = 1u << s_SecondLevelLog2;
+		static constexpr uint32_t s_FirstLevelCount = 64;
+
+		struct Node
+		{
+			uint64_t Offset = 0;
+			// in granularity units
+			uint64_t Size = 0;
+			uint32_t PrevPhysical = InvalidNode;
+			uint32_t NextPhysical = InvalidNode;
+			uint32_t PrevFree = InvalidNode;
+			uint32_t NextFree = InvalidNode;
+			bool Used = false;
+		};
+
+		static void mapping(uint64_t units, uint32_t& firstLevel, uint32_t& secondLevel);
+
+		uint32_t createNode(uint64_t offset, uint64_t units);
+		void destroyNode(uint32_t node);
+		void insertFree(uint32_t node);
+		void removeFree(uint32_t node);
+		uint32_t findFree(uint64_t units) const;
+		// splits units off the front of node; the front keeps the node index
+		uint32_t split(uint32_t node, uint64_t units);
+		void merge(uint32_t node, uint32_t next);
+	private:
+		uint64_t m_Capacity = 0;
+		uint64_t m_Granularity = 256;
+		uint64_t m_FreeBytes = 0;
+		uint32_t m_AllocationCount = 0;
+
+		uint64_t m_FirstLevelBitmap = 0;
+		uint32_t m_SecondLevelBitmaps[s_FirstLevelCount] = {};
+		uint32_t m_FreeHeads[s_FirstLevelCount][s_SecondLevelCount];
+
+		std::vector<Node> m_Nodes;
+		std::vector<uint32_t> m_FreeNodes;
+	};
+
+}
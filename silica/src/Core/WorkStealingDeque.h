@@ -0,0 +1,122 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace silica {
+
+	// Chase-Lev deque (Le et al., weak memory model version). The owning thread
+	// pushes and pops at the bottom, any other thread steals from the top.
+	template<typename T>
+	class WorkStealingDeque
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "WorkStealingDeque stores items in atomics");
+	public:
+		explicit WorkStealingDeque(size_t capacity = 1024)
+		{
+			size_t size = 2;
+			while (size < capacity)
+				size <<= 1;
+
+			m_Buffers.push_back(std::make_unique<Buffer>(size));
+			m_Buffer.store(m_Buffers.back().get(), std::memory_order_relaxed);
+		}
+
+		WorkStealingDeque(const WorkStealingDeque&) = delete;
+		WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+		// owner thread only
+		void push(T item)
+		{
+			int64_t bottom = m_Bottom.load(std::memory_order_relaxed);
+			int64_t top = m_Top.load(std::memory_order_acquire);
+			Buffer* buffer = m_Buffer.load(std::memory_order_relaxed);
+
+			if (bottom - top > (int64_t)buffer->Mask)
+				buffer = grow(buffer, top, bottom);
+
+			buffer->put(bottom, item);
+			m_Bottom.store(bottom + 1, std::memory_order_release);
+		}
+
+		// owner thread only
+		bool pop(T& out)
+		{
+			int64_t bottom = m_Bottom.load(std::memory_order_relaxed) - 1;
+			Buffer* buffer = m_Buffer.load(std::memory_order_relaxed);
+			m_Bottom.store(bottom, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t top = m_Top.load(std::memory_order_relaxed);
+
+			if (top > bottom)
+			{
+				m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+				return false;
+			}
+
+			out = buffer->get(bottom);
+			if (top != bottom)
+				return true;
+
+			// last item, race the thieves for it
+			bool won = m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+			m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+			return won;
+		}
+
+		bool steal(T& out)
+		{
+			int64_t top = m_Top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t bottom = m_Bottom.load(std::memory_order_acquire);
+
+			if (top >= bottom)
+				return false;
+
+			Buffer* buffer = m_Buffer.load(std::memory_order_acquire);
+			out = buffer->get(top);
+
+			return m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+		}
+
+		bool isEmpty() const
+		{
+			return m_Top.load(std::memory_order_relaxed) >= m_Bottom.load(std::memory_order_relaxed);
+		}
+	private:
+		struct Buffer
+		{
+			explicit Buffer(size_t size)
+				: Mask(size - 1), Items(std::make_unique<std::atomic<T>[]>(size))
+			{
+			}
+
+			T get(int64_t index) const { return Items[index & Mask].load(std::memory_order_relaxed); }
+			void put(int64_t index, T item) { Items[index & Mask].store(item, std::memory_order_relaxed); }
+
+			size_t Mask;
+			std::unique_ptr<std::atomic<T>[]> Items;
+		};
+
+		Buffer* grow(Buffer* buffer, int64_t top, int64_t bottom)
+		{
+			auto& grown = m_Buffers.emplace_back(std::make_unique<Buffer>((buffer->Mask + 1) * 2));
+			for (int64_t i = top; i < bottom; i++)
+				grown->put(i, buffer->get(i));
+
+			// thieves may still be reading the old buffer, so it stays alive until the deque is destroyed
+			m_Buffer.store(grown.get(), std::memory_order_release);
+			return grown.get();
+		}
+	private:
+		alignas(64) std::atomic<int64_t> m_Top = 0;
+		alignas(64) std::atomic<int64_t> m_Bottom = 0;
+		std::atomic<Buffer*> m_Buffer = nullptr;
+
+		std::vector<std::unique_ptr<Buffer>> m_Buffers;
+	};
+
+}
@@ -0,0 +1,130 @@
+#include "BindlessHeap.h"
+
+#include "Core/Assert.h"
+
+namespace silica {
+
+    void BindlessHeap::create(nvrhi::IDevice* device, uint32_t capacity)
+    {
+        m_Device = device;
+        m_Capacity = capacity;
+
+        nvrhi::BindlessLayoutDesc layoutDesc = nvrhi::BindlessLayoutDesc()
+            .setVisibility(nvrhi::ShaderType::All)
+            .setFirstSlot(0)
+            .setMaxCapacity(capacity)
+            .addRegisterSpace(nvrhi::BindingLayoutItem::Texture_SRV(1))
+            .addRegisterSpace(nvrhi::BindingLayoutItem::Texture_UAV(2))
+            .addRegisterSpace(nvrhi::BindingLayoutItem::RawBuffer_SRV(3))
+            .addRegisterSpace(nvrhi::BindingLayoutItem::RawBuffer_UAV(4));
+
+        m_Layout = m_Device->createBindlessLayout(layoutDesc);
+        SIL_ASSERT_OR_ERROR(m_Layout, "Failed to create the bindless layout");
+        if (!m_Layout)
+            return;
+
+        m_DescriptorTable = m_Device->createDescriptorTable(m_Layout);
+        // nvrhi tables start empty; sizing up front keeps indices stable without ever reallocating the set
+        m_Device->resizeDescriptorTable(m_DescriptorTable, capacity, false);
+
+        SIL_DEBUG_LOG("Created bindless descriptor table with {} slots", capacity);
+    }
+
+    void BindlessHeap::destroy()
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        m_DescriptorTable = nullptr;
+        m_Layout = nullptr;
+        m_FreeIndices.clear();
+        m_PendingFrees.clear();
+        m_NextIndex = 0;
+        m_Capacity = 0;
+        m_Device = nullptr;
+    }
+
+    void BindlessHeap::beginFrame(uint64_t completedValue)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        while (!m_PendingFrees.empty() && m_PendingFrees.front().GpuValue <= completedValue)
+        {
+            m_FreeIndices.push_back(m_PendingFrees.front().Index);
+            m_PendingFrees.pop_front();
+        }
+    }
+
+    uint32_t BindlessHeap::registerTexture(nvrhi::ITexture* texture, bool storage)
+    {
+        return write(storage ? nvrhi::BindingSetItem::Texture_UAV(0, texture) : nvrhi::BindingSetItem::Texture_SRV(0, texture));
+    }
+
+    uint32_t BindlessHeap::registerBuffer(nvrhi::IBuffer* buffer, bool storage)
+    {
+        SIL_ASSERT(buffer->getDesc().canHaveRawViews, "Bindless buffers are bound as raw views and need canHaveRawViews");
+        return write(storage ? nvrhi::BindingSetItem::RawBuffer_UAV(0, buffer) : nvrhi::BindingSetItem::RawBuffer_SRV(0, buffer));
+    }
+
+    void BindlessHeap::release(uint32_t index, uint64_t gpuValue)
+    {
+        if (index == BindlessIndex::Invalid)
+            return;
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        // the slot keeps its old descriptor until reuse; partially bound tables allow that as long as shaders no longer index it
+        m_PendingFrees.push_back({ gpuValue, index });
+    }
+
+    BindlessStats BindlessHeap::getStats() const
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        BindlessStats stats;
+        stats.Capacity = m_Capacity;
+        stats.PendingFree = (uint32_t)m_PendingFrees.size();
+        stats.Used = m_NextIndex - (uint32_t)m_FreeIndices.size() - stats.PendingFree;
+        return stats;
+    }
+
+    uint32_t BindlessHeap::allocate()
+    {
+        if (!m_FreeIndices.empty())
+        {
+            uint32_t index = m_FreeIndices.back();
+            m_FreeIndices.pop_back();
+            return index;
+        }
+
+        if (m_NextIndex < m_Capacity)
+            return m_NextIndex++;
+
+        return BindlessIndex::Invalid;
+    }
+
+    uint32_t BindlessHeap::write(const nvrhi::BindingSetItem& item)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        if (!m_DescriptorTable)
+            return BindlessIndex::Invalid;
+
+        uint32_t index = allocate();
+        if (index == BindlessIndex::Invalid)
+        {
+            SIL_ERROR("Bindless descriptor table is full ({} slots)", m_Capacity);
+            return BindlessIndex::Invalid;
+        }
+
+        nvrhi::BindingSetItem slotItem = item;
+        slotItem.slot = index;
+        if (!m_Device->writeDescriptorTable(m_DescriptorTable, slotItem))
+        {
+            m_FreeIndices.push_back(index);
+            return BindlessIndex::Invalid;
+        }
+
+        return index;
+    }
+
+}
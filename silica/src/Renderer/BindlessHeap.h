@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Device.h"
+
+#include <nvrhi/nvrhi.h>
+
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace silica {
+
+    // One update-after-bind descriptor table shared by every draw. Sampled textures, storage
+    // textures, and read-only and read-write buffers each get their own binding (register
+    // spaces 1 to 4, Vulkan bindings 0 to 3). They share a single index space, so a resource
+    // keeps the same index whatever it was registered as. Released indices are handed out
+    // again only after the frames that could still read them have finished.
+    class BindlessHeap
+    {
+    public:
+        BindlessHeap() = default;
+        ~BindlessHeap() = default;
+
+        void create(nvrhi::IDevice* device, uint32_t capacity);
+        void destroy();
+
+        // recycles indices released by submissions up to completedValue
+        void beginFrame(uint64_t completedValue);
+
+        // BindlessIndex::Invalid when the table is full
+        uint32_t registerTexture(nvrhi::ITexture* texture, bool storage);
+        // buffers are bound as raw (byte address) views, so they need canHaveRawViews
+        uint32_t registerBuffer(nvrhi::IBuffer* buffer, bool storage);
+        void release(uint32_t index, uint64_t gpuValue);
+
+        nvrhi::IBindingLayout* getLayout() const { return m_Layout; }
+        nvrhi::IDescriptorTable* getDescriptorTable() const { return m_DescriptorTable; }
+
+        BindlessStats getStats() const;
+    private:
+        uint32_t allocate();
+        uint32_t write(const nvrhi::BindingSetItem& item);
+    private:
+        struct PendingFree
+        {
+            uint64_t GpuValue = 0;
+            uint32_t Index = 0;
+        };
+
+        nvrhi::IDevice* m_Device = nullptr;
+        nvrhi::BindingLayoutHandle m_Layout;
+        nvrhi::DescriptorTableHandle m_DescriptorTable;
+
+        uint32_t m_Capacity = 0;
+        // indices below this have been handed out at least once
+        uint32_t m_NextIndex = 0;
+        std::vector<uint32_t> m_FreeIndices;
+        std::deque<PendingFree> m_PendingFrees;
+
+        mutable std::mutex m_Mutex;
+    };
+
+}
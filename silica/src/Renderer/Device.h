@@ -4,12 +4,216 @@
 
 #include "Resource.h"
 
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace nvrhi {
+
+    class IResource;
+    class ITexture;
+    class IBuffer;
+    class ICommandList;
+    class IFramebuffer;
+    class IGraphicsPipeline;
+    class IComputePipeline;
+    class IBindingLayout;
+    class IDescriptorTable;
+
+    struct GraphicsPipelineDesc;
+    struct ComputePipelineDesc;
+    struct BufferDesc;
+    struct TextureDesc;
+
+    enum class CommandQueue : uint8_t;
+
+}
+
 namespace silica {
 
     class Instance;
 
+    enum class PresentMode
+    {
+        Fifo = 0,
+        FifoRelaxed,
+        Mailbox,
+        Immediate
+    };
+
     struct DeviceInfo
     {
+        // clamped to [1, SIL_MAX_FRAMES_IN_FLIGHT]
+        uint32_t FramesInFlight = 2;
+        // 0 picks minImageCount + 1; clamped to what the surface supports
+        uint32_t SwapchainImageCount = 0;
+        // falls back Immediate -> Mailbox -> Fifo, Mailbox -> Fifo and FifoRelaxed -> Fifo when unsupported
+        PresentMode PreferredPresentMode = PresentMode::Mailbox;
+
+        // staging ring capacity per frame in flight; larger uploads fall back to a dedicated buffer
+        uint64_t UploadRingSizePerFrame = 16 * 1024 * 1024;
+
+        // device-local memory blocks that placed resources are sub-allocated from
+        uint64_t MemoryBlockSize = 64 * 1024 * 1024;
+        // ring per resource kind for MemoryStrategy::Transient, created on first use
+        uint64_t TransientMemorySize = 32 * 1024 * 1024;
+
+        // adapter override, checked in this order; when nothing suitable matches, the highest scored GPU is used.
+        // AdapterIndex is the enumeration index shown in the logged ranking, AdapterName a case-insensitive
+        // substring of the device name, and a zero vendor or device ID matches any
+        int32_t AdapterIndex = -1;
+        std::string AdapterName;
+        uint32_t AdapterVendorID = 0;
+        uint32_t AdapterDeviceID = 0;
+
+        // one update-after-bind descriptor table for all textures and buffers; ignored without descriptor indexing support
+        bool EnableBindless = false;
+        uint32_t BindlessCapacity = 16384;
+
+        // loaded at device creation and rewritten on shutdown; empty disables persistence
+        std::string PipelineCachePath = "silica_pipeline_cache.bin";
+
+        // fractions of a device-local heap's budget; crossing one upwards raises the memory budget callback
+        std::vector<float> MemoryBudgetThresholds = { 0.75f, 0.9f, 0.95f };
+
+        // only used when the instance was created with InstanceInfo::Headless
+        uint32_t HeadlessWidth = 1280;
+        uint32_t HeadlessHeight = 720;
+        uint32_t HeadlessImageCount = 3;
+    };
+
+    struct FrameSubmitStats
+    {
+        uint64_t FrameNumber = 0;
+        uint32_t Submissions = 0;
+        uint32_t CommandLists = 0;
+    };
+
+    struct UploadStats
+    {
+        uint64_t BytesUploaded = 0;
+        uint32_t Uploads = 0;
+        uint32_t DedicatedFallbacks = 0;
+    };
+
+    struct PipelineLibraryStats
+    {
+        uint64_t Hits = 0;
+        uint64_t Misses = 0;
+        uint32_t Pending = 0;
+        uint32_t Failures = 0;
+        double TotalCompileMilliseconds = 0.0;
+        double MaxCompileMilliseconds = 0.0;
+    };
+
+    // optional GPU features negotiated at device creation; engine code picks its fast paths from these
+    struct DeviceCapabilities
+    {
+        bool Synchronization2 = false;
+        bool BufferDeviceAddress = false;
+        bool DescriptorIndexing = false;
+        bool DynamicRendering = false;
+        bool MemoryBudget = false;
+        bool PresentWait = false;
+        bool ShaderFloat16 = false;
+        bool SampleRateShading = false;
+        bool SamplerAnisotropy = false;
+    };
+
+    struct DeviceStartupPhase
+    {
+        const char* Name = nullptr;
+        double Milliseconds = 0.0;
+    };
+
+    // wall time of each step of device creation, in order
+    struct DeviceStartupStats
+    {
+        std::vector<DeviceStartupPhase> Phases;
+        double TotalMilliseconds = 0.0;
+    };
+
+    namespace BindlessIndex {
+
+        constexpr uint32_t Invalid = ~0u;
+
+    }
+
+    struct BindlessStats
+    {
+        uint32_t Capacity = 0;
+        uint32_t Used = 0;
+        // released, waiting for the frames that could still read them
+        uint32_t PendingFree = 0;
+    };
+
+    enum class MemoryCategory
+    {
+        Texture = 0,
+        Buffer,
+        RenderTarget,
+        Count
+    };
+
+    enum class MemoryStrategy
+    {
+        // TLSF sub-allocation, lives until releasePlacedResource
+        General = 0,
+        // linear allocation from a ring, reclaimed automatically once the current frame has finished on the GPU
+        Transient
+    };
+
+    struct MemoryAllocatorStats
+    {
+        uint32_t Blocks = 0;
+        uint64_t BlockBytes = 0;
+        uint32_t PlacedResources = 0;
+        uint64_t PlacedBytes = 0;
+        uint32_t TransientResources = 0;
+        uint64_t TransientBytes = 0;
+        // too large for a block, CPU visible or volatile, so they got their own allocation
+        uint32_t DedicatedResources = 0;
+    };
+
+    struct MemoryHeapBudget
+    {
+        uint64_t Size = 0;
+        // what the driver allows this process to use; the heap size without VK_EXT_memory_budget
+        uint64_t Budget = 0;
+        uint64_t Usage = 0;
+        bool DeviceLocal = false;
+    };
+
+    struct MemoryBudget
+    {
+        std::vector<MemoryHeapBudget> Heaps;
+        // engine-side accounting, independent of which heap the memory came from
+        uint64_t CategoryBytes[(size_t)MemoryCategory::Count] = {};
+        // false when usage is only the engine's own estimate because VK_EXT_memory_budget is missing
+        bool DriverReported = false;
+    };
+
+    struct MemoryBudgetEvent
+    {
+        uint32_t HeapIndex = 0;
+        float Threshold = 0.0f;
+        uint64_t Usage = 0;
+        uint64_t Budget = 0;
+    };
+
+    using MemoryBudgetCallback = std::function<void(const MemoryBudgetEvent&)>;
+
+    struct GpuScopeTiming
+    {
+        std::string Name;
+        uint32_t Depth = 0;
+        double Milliseconds = 0.0;
+    };
+
+    struct GpuFrameTimings
+    {
+        uint64_t FrameNumber = 0;
+        std::vector<GpuScopeTiming> Scopes;
     };
 
     class Device : public Resource
@@ -18,8 +222,99 @@ namespace silica {
         Device();
         ~Device();
 
-        virtual void beginFrame() = 0;
+        // returns false when there is nothing to render into (e.g. minimised window); skip endFrame in that case
+        virtual bool beginFrame() = 0;
         virtual void endFrame() = 0;
+
+        virtual nvrhi::ITexture* getCurrentBackBuffer() = 0;
+        virtual uint32_t getBackBufferIndex() const = 0;
+        virtual uint32_t getBackBufferCount() const = 0;
+        virtual uint32_t getFramesInFlight() const = 0;
+
+        // closed command lists are batched and submitted together with the frame's semaphores in endFrame,
+        // in ascending order and then in the order they were handed in. Compute and copy lists are submitted
+        // on their own queues first and the graphics batch waits for them
+        virtual void submitCommandList(nvrhi::ICommandList* commandList, uint32_t order = 0) = 0;
+
+        // open command list owned by the calling thread for the current frame, recycled once the frame retires.
+        // Safe to call from any thread between beginFrame and endFrame
+        virtual nvrhi::ICommandList* beginCommandList() = 0;
+        // closes the list and submits it with the given order
+        virtual void endCommandList(nvrhi::ICommandList* commandList, uint32_t order = 0) = 0;
+
+        // Compute and Copy have their own queues only when the GPU exposes dedicated families
+        virtual bool hasDedicatedQueue(nvrhi::CommandQueue queue) const = 0;
+        // submits a closed command list on its own queue right away, outside the frame batch; returns the submission to wait on
+        virtual uint64_t executeCommandList(nvrhi::ICommandList* commandList) = 0;
+        // GPU-side wait: later work on waitQueue starts after the submission on executionQueue has completed
+        virtual void queueWaitForCommandList(nvrhi::CommandQueue waitQueue, nvrhi::CommandQueue executionQueue, uint64_t submission) = 0;
+
+        // copies through the staging ring; recorded into the frame's copy list and visible to work submitted after endFrame
+        virtual void uploadBuffer(nvrhi::IBuffer* buffer, const void* data, size_t size, uint64_t destOffset = 0) = 0;
+        virtual void uploadTexture(nvrhi::ITexture* texture, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch = 0) = 0;
+        virtual UploadStats getLastFrameUploadStats() const = 0;
+        virtual FrameSubmitStats getLastFrameSubmitStats() const = 0;
+
+        // GPU progress as a monotonic value: each submission signals the next value once its work completes.
+        // Tag per-frame resources with getCurrentFrameGpuValue() and reclaim them once getCompletedGpuValue() reaches it
+        virtual uint64_t getCompletedGpuValue() const = 0;
+        virtual uint64_t getCurrentFrameGpuValue() const = 0;
+        virtual void waitForGpuValue(uint64_t value) = 0;
+
+        // destroyed once the GPU has finished the last frame that used it (see Resource::markUsed, otherwise
+        // the current frame). Reclaimed in beginFrame, so releasing mid-session never idles the device
+        virtual void releaseResource(std::shared_ptr<Resource> resource) = 0;
+        // runs release in a later beginFrame, once the GPU has finished the current frame
+        virtual void deferRelease(std::function<void()> release) = 0;
+
+        // cached by a hash of the whole description. A miss starts compiling on the job system and returns
+        // nullptr until the pipeline is ready, so callers skip the draw or dispatch instead of stalling the frame
+        virtual nvrhi::IGraphicsPipeline* getGraphicsPipeline(const nvrhi::GraphicsPipelineDesc& desc, nvrhi::IFramebuffer* framebuffer) = 0;
+        virtual nvrhi::IComputePipeline* getComputePipeline(const nvrhi::ComputePipelineDesc& desc) = 0;
+        // blocks until every requested pipeline has compiled, e.g. behind a loading screen
+        virtual void waitForPipelines() = 0;
+        virtual PipelineLibraryStats getPipelineLibraryStats() const = 0;
+        virtual const DeviceStartupStats& getStartupStats() const = 0;
+
+        // resources bound into shared device-local memory blocks instead of one allocation each. The device
+        // keeps them alive until released (or until the frame retires for Transient); don't hold handles past that
+        virtual nvrhi::IBuffer* createPlacedBuffer(const nvrhi::BufferDesc& desc, MemoryStrategy strategy = MemoryStrategy::General) = 0;
+        virtual nvrhi::ITexture* createPlacedTexture(const nvrhi::TextureDesc& desc, MemoryStrategy strategy = MemoryStrategy::General) = 0;
+        // memory is reused once the GPU has finished the current frame
+        virtual void releasePlacedResource(nvrhi::IResource* resource) = 0;
+        virtual MemoryAllocatorStats getMemoryAllocatorStats() const = 0;
+
+        virtual const DeviceCapabilities& getCapabilities() const = 0;
+
+        // false unless DeviceInfo::EnableBindless was set and the GPU supports descriptor indexing
+        virtual bool isBindlessEnabled() const = 0;
+        // stable index into the bindless table until released, or BindlessIndex::Invalid. Storage registers a
+        // UAV instead of an SRV; buffers are bound as raw views
+        virtual uint32_t registerBindlessTexture(nvrhi::ITexture* texture, bool storage = false) = 0;
+        virtual uint32_t registerBindlessBuffer(nvrhi::IBuffer* buffer, bool storage = false) = 0;
+        // the index is handed out again once the GPU has finished the current frame
+        virtual void releaseBindless(uint32_t index) = 0;
+        // bind the table with the layout in the pipeline's binding layouts; null when bindless is disabled
+        virtual nvrhi::IBindingLayout* getBindlessLayout() const = 0;
+        virtual nvrhi::IDescriptorTable* getBindlessTable() const = 0;
+        virtual BindlessStats getBindlessStats() const = 0;
+
+        // refreshed once per frame in beginFrame
+        virtual MemoryBudget getMemoryBudget() const = 0;
+        // add a resource's size when it is created and subtract it again when it is released
+        virtual void trackMemory(MemoryCategory category, int64_t bytes) = 0;
+        // called from beginFrame when a device-local heap crosses one of DeviceInfo::MemoryBudgetThresholds
+        virtual void setMemoryBudgetCallback(MemoryBudgetCallback callback) = 0;
+
+        // timestamps are written into the open command list; scopes nest per command list
+        virtual void beginGpuScope(nvrhi::ICommandList* commandList, const char* name) = 0;
+        virtual void endGpuScope(nvrhi::ICommandList* commandList) = 0;
+        // oldest first, at most frameCount entries
+        virtual std::vector<GpuFrameTimings> getGpuFrameTimings(uint32_t frameCount) const = 0;
+
+        // full memory barrier between everything recorded so far and what follows, for resources placed over memory
+        // another resource used before; nvrhi has no aliasing barriers. Ends the command list's current render pass
+        virtual void aliasingBarrier(nvrhi::ICommandList* commandList) = 0;
     protected:
         void setNvrhiDevice(void* nativeDevice);
         void resetNvrhiDevice();
@@ -33,6 +328,33 @@ namespace silica {
     private:
         struct NvImpl;
         std::unique_ptr<NvImpl> m_Nv;
+
+        friend class RenderGraph;
+    };
+
+    class GpuScope
+    {
+    public:
+        GpuScope(Device& device, nvrhi::ICommandList* commandList, const char* name)
+            : m_Device(device), m_CommandList(commandList)
+        {
+            m_Device.beginGpuScope(m_CommandList, name);
+        }
+
+        ~GpuScope()
+        {
+            m_Device.endGpuScope(m_CommandList);
+        }
+
+        GpuScope(const GpuScope&) = delete;
+        GpuScope& operator=(const GpuScope&) = delete;
+    private:
+        Device& m_Device;
+        nvrhi::ICommandList* m_CommandList;
     };
 
 }
+
+#define SIL_GPU_SCOPE_CONCAT_IMPL(a, b) a##b
+#define SIL_GPU_SCOPE_CONCAT(a, b) SIL_GPU_SCOPE_CONCAT_IMPL(a, b)
+#define SIL_GPU_SCOPE(device, commandList, name) ::silica::GpuScope SIL_GPU_SCOPE_CONCAT(gpuScope, __LINE__)(device, commandList, name)
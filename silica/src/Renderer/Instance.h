@@ -7,7 +7,7 @@
 
 namespace silica {
 
-#define SIL_FRAMES_IN_FLIGHT 2
+#define SIL_MAX_FRAMES_IN_FLIGHT 4
 
     enum class RendererAPI
     {
@@ -22,6 +22,29 @@ namespace silica {
     {
         RendererAPI API = RendererAPI::Vulkan;
         GLFWwindow* Window = nullptr;
+
+        // renders into offscreen textures without a window or VkSurfaceKHR
+        bool Headless = false;
+
+        // routes the driver's host allocations through a tracking, pooled allocator instead of its own
+        bool TrackHostAllocations = false;
+    };
+
+    struct HostMemoryStats
+    {
+        // indexed like VkSystemAllocationScope: command, object, cache, device, instance
+        struct Scope
+        {
+            uint64_t Bytes = 0;
+            uint64_t PeakBytes = 0;
+            uint64_t Allocations = 0;
+            uint64_t LiveAllocations = 0;
+        };
+
+        Scope Scopes[5];
+        // allocations the driver made itself and only reported, e.g. executable memory
+        uint64_t InternalBytes = 0;
+        uint64_t PooledAllocations = 0;
     };
 
     class Instance
@@ -30,6 +53,9 @@ namespace silica {
         virtual ~Instance() = default;
 
         virtual std::shared_ptr<Device> createDevice(const DeviceInfo& deviceInfo) = 0;
+
+        // all zero unless InstanceInfo::TrackHostAllocations is set
+        virtual HostMemoryStats getHostMemoryStats() const = 0;
     };
 
     std::unique_ptr<Instance> createInstance(const InstanceInfo& instanceInfo);
@@ -0,0 +1,380 @@
+#include "PipelineLibrary.h"
+
+#include "Core/Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+namespace silica {
+
+    namespace utils {
+
+        // FNV-1a, so hashes do not depend on the standard library or on pointer values
+        class PipelineHasher
+        {
+        public:
+            void addBytes(const void* data, size_t size)
+            {
+                const uint8_t* bytes = static_cast<const uint8_t*>(data);
+                for (size_t i = 0; i < size; i++)
+                {
+                    m_Hash ^= bytes[i];
+                    m_Hash *= 0x100000001b3ull;
+                }
+            }
+
+            template<typename T>
+            void add(const T& value)
+            {
+                static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>, "only scalar fields are hashed directly");
+
+                // widened first so padding and the underlying enum type never reach the hash
+                uint64_t widened;
+                if constexpr (std::is_floating_point_v<T>)
+                {
+                    double d = value;
+                    static_assert(sizeof(d) == sizeof(widened));
+                    std::memcpy(&widened, &d, sizeof(widened));
+                }
+                else
+                {
+                    widened = (uint64_t)value;
+                }
+                addBytes(&widened, sizeof(widened));
+            }
+
+            void add(const std::string& value)
+            {
+                add(value.size());
+                addBytes(value.data(), value.size());
+            }
+
+            void add(const nvrhi::BindingLayoutItem& item)
+            {
+                add(item.slot);
+                add(item.type);
+                add(item.size);
+            }
+
+            void add(nvrhi::IBindingLayout* layout)
+            {
+                add(layout != nullptr);
+                if (!layout)
+                    return;
+
+                if (const nvrhi::BindingLayoutDesc* desc = layout->getDesc())
+                {
+                    add(desc->visibility);
+                    add(desc->registerSpace);
+                    add(desc->bindings.size());
+                    for (const nvrhi::BindingLayoutItem& item : desc->bindings)
+                        add(item);
+                }
+                else if (const nvrhi::BindlessLayoutDesc* bindless = layout->getBindlessDesc())
+                {
+                    add(bindless->visibility);
+                    add(bindless->firstSlot);
+                    add(bindless->maxCapacity);
+                    add(bindless->registerSpaces.size());
+                    for (const nvrhi::BindingLayoutItem& item : bindless->registerSpaces)
+                        add(item);
+                }
+            }
+
+            void add(const nvrhi::BindingLayoutVector& layouts)
+            {
+                add(layouts.size());
+                for (nvrhi::IBindingLayout* layout : layouts)
+                    add(layout);
+            }
+
+            void add(nvrhi::IInputLayout* inputLayout)
+            {
+                add(inputLayout != nullptr);
+                if (!inputLayout)
+                    return;
+
+                uint32_t count = inputLayout->getNumAttributes();
+                add(count);
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    const nvrhi::VertexAttributeDesc* attribute = inputLayout->getAttributeDesc(i);
+                    add(attribute->name);
+                    add(attribute->format);
+                    add(attribute->arraySize);
+                    add(attribute->bufferIndex);
+                    add(attribute->offset);
+                    add(attribute->elementStride);
+                    add(attribute->isInstanced);
+                }
+            }
+
+            void add(const nvrhi::RenderState& state)
+            {
+                const nvrhi::BlendState& blend = state.blendState;
+                for (const nvrhi::BlendState::RenderTarget& target : blend.targets)
+                {
+                    add(target.blendEnable);
+                    add(target.srcBlend);
+                    add(target.destBlend);
+                    add(target.blendOp);
+                    add(target.srcBlendAlpha);
+                    add(target.destBlendAlpha);
+                    add(target.blendOpAlpha);
+                    add(target.colorWriteMask);
+                }
+                add(blend.alphaToCoverageEnable);
+
+                const nvrhi::DepthStencilState& depthStencil = state.depthStencilState;
+                add(depthStencil.depthTestEnable);
+                add(depthStencil.depthWriteEnable);
+                add(depthStencil.depthFunc);
+                add(depthStencil.stencilEnable);
+                add(depthStencil.stencilReadMask);
+                add(depthStencil.stencilWriteMask);
+                add(depthStencil.stencilRefValue);
+                add(depthStencil.dynamicStencilRef);
+                for (const nvrhi::DepthStencilState::StencilOpDesc* face : { &depthStencil.frontFaceStencil, &depthStencil.backFaceStencil })
+                {
+                    add(face->failOp);
+                    add(face->depthFailOp);
+                    add(face->passOp);
+                    add(face->stencilFunc);
+                }
+
+                const nvrhi::RasterState& raster = state.rasterState;
+                add(raster.fillMode);
+                add(raster.cullMode);
+                add(raster.frontCounterClockwise);
+                add(raster.depthClipEnable);
+                add(raster.scissorEnable);
+                add(raster.multisampleEnable);
+                add(raster.antialiasedLineEnable);
+                add(raster.depthBias);
+                add(raster.depthBiasClamp);
+                add(raster.slopeScaledDepthBias);
+                add(raster.forcedSampleCount);
+                add(raster.programmableSamplePositionsEnable);
+                add(raster.conservativeRasterEnable);
+                add(raster.quadFillEnable);
+            }
+
+            void add(const nvrhi::FramebufferInfo& info)
+            {
+                add(info.colorFormats.size());
+                for (nvrhi::Format format : info.colorFormats)
+                    add(format);
+                add(info.depthFormat);
+                add(info.sampleCount);
+                add(info.sampleQuality);
+            }
+
+            uint64_t get() const { return m_Hash; }
+        private:
+            uint64_t m_Hash = 0xcbf29ce484222325ull;
+        };
+
+    }
+
+    void PipelineLibrary::create(nvrhi::IDevice* device)
+    {
+        m_Device = device;
+    }
+
+    void PipelineLibrary::destroy()
+    {
+        waitForPending();
+
+        {
+            std::lock_guard<std::mutex> lock(m_ShaderHashMutex);
+            m_ShaderHashes.clear();
+        }
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (m_Stats.Misses > 0)
+            SIL_INFO("Pipeline library: {} hits, {} misses, {:.2f} ms spent compiling (slowest {:.2f} ms)", m_Stats.Hits, m_Stats.Misses, m_Stats.TotalCompileMilliseconds, m_Stats.MaxCompileMilliseconds);
+
+        m_GraphicsPipelines.clear();
+        m_ComputePipelines.clear();
+        m_Device = nullptr;
+    }
+
+    nvrhi::IGraphicsPipeline* PipelineLibrary::getGraphicsPipeline(const nvrhi::GraphicsPipelineDesc& desc, nvrhi::IFramebuffer* framebuffer)
+    {
+        auto& entry = getGraphicsEntry(desc, framebuffer);
+        return entry.Ready.load(std::memory_order_acquire) ? entry.Pipeline.Get() : nullptr;
+    }
+
+    nvrhi::IComputePipeline* PipelineLibrary::getComputePipeline(const nvrhi::ComputePipelineDesc& desc)
+    {
+        auto& entry = getComputeEntry(desc);
+        return entry.Ready.load(std::memory_order_acquire) ? entry.Pipeline.Get() : nullptr;
+    }
+
+    std::shared_future<nvrhi::GraphicsPipelineHandle> PipelineLibrary::requestGraphicsPipeline(const nvrhi::GraphicsPipelineDesc& desc, nvrhi::IFramebuffer* framebuffer)
+    {
+        return getGraphicsEntry(desc, framebuffer).Future;
+    }
+
+    std::shared_future<nvrhi::ComputePipelineHandle> PipelineLibrary::requestComputePipeline(const nvrhi::ComputePipelineDesc& desc)
+    {
+        return getComputeEntry(desc).Future;
+    }
+
+    void PipelineLibrary::waitForPending()
+    {
+        SIL_PROFILE_FUNCTION();
+
+        JobSystem::wait(m_PendingCompiles);
+    }
+
+    PipelineLibraryStats PipelineLibrary::getStats() const
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_Stats;
+    }
+
+    uint64_t PipelineLibrary::hashGraphicsPipeline(const nvrhi::GraphicsPipelineDesc& desc, const nvrhi::FramebufferInfo& framebufferInfo)
+    {
+        utils::PipelineHasher hasher;
+        hasher.add(desc.primType);
+        hasher.add(desc.patchControlPoints);
+        hasher.add(desc.inputLayout.Get());
+        for (nvrhi::IShader* shader : { desc.VS.Get(), desc.HS.Get(), desc.DS.Get(), desc.GS.Get(), desc.PS.Get() })
+            hasher.add(hashShader(shader));
+        hasher.add(desc.renderState);
+        hasher.add(desc.bindingLayouts);
+        hasher.add(framebufferInfo);
+        return hasher.get();
+    }
+
+    uint64_t PipelineLibrary::hashComputePipeline(const nvrhi::ComputePipelineDesc& desc)
+    {
+        utils::PipelineHasher hasher;
+        hasher.add(hashShader(desc.CS));
+        hasher.add(desc.bindingLayouts);
+        return hasher.get();
+    }
+
+    uint64_t PipelineLibrary::hashShader(nvrhi::IShader* shader)
+    {
+        if (!shader)
+            return 0;
+
+        std::lock_guard<std::mutex> lock(m_ShaderHashMutex);
+
+        auto it = m_ShaderHashes.find(shader);
+        if (it != m_ShaderHashes.end())
+            return it->second.Hash;
+
+        const nvrhi::ShaderDesc& desc = shader->getDesc();
+
+        const void* bytecode = nullptr;
+        size_t size = 0;
+        shader->getBytecode(&bytecode, &size);
+
+        utils::PipelineHasher hasher;
+        hasher.add(desc.shaderType);
+        hasher.add(desc.entryName);
+        hasher.add(size);
+        hasher.addBytes(bytecode, size);
+
+        // the handle keeps the address from being reused by a different shader
+        m_ShaderHashes[shader] = { nvrhi::ShaderHandle(shader), hasher.get() };
+        return hasher.get();
+    }
+
+    PipelineLibrary::Entry<nvrhi::GraphicsPipelineHandle>& PipelineLibrary::getGraphicsEntry(const nvrhi::GraphicsPipelineDesc& desc, nvrhi::IFramebuffer* framebuffer)
+    {
+        uint64_t hash = hashGraphicsPipeline(desc, framebuffer->getFramebufferInfo());
+
+        bool inserted = false;
+        auto& entry = findOrInsert(m_GraphicsPipelines, hash, inserted);
+        if (inserted)
+        {
+            compile(entry, hash, "graphics", [desc, framebuffer = nvrhi::FramebufferHandle(framebuffer)](nvrhi::IDevice* device)
+            {
+                return device->createGraphicsPipeline(desc, framebuffer);
+            });
+        }
+
+        return entry;
+    }
+
+    PipelineLibrary::Entry<nvrhi::ComputePipelineHandle>& PipelineLibrary::getComputeEntry(const nvrhi::ComputePipelineDesc& desc)
+    {
+        uint64_t hash = hashComputePipeline(desc);
+
+        bool inserted = false;
+        auto& entry = findOrInsert(m_ComputePipelines, hash, inserted);
+        if (inserted)
+        {
+            compile(entry, hash, "compute", [desc](nvrhi::IDevice* device)
+            {
+                return device->createComputePipeline(desc);
+            });
+        }
+
+        return entry;
+    }
+
+    template<typename T>
+    PipelineLibrary::Entry<T>& PipelineLibrary::findOrInsert(EntryMap<T>& entries, uint64_t hash, bool& inserted)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        auto& entry = entries[hash];
+        inserted = entry == nullptr;
+
+        if (inserted)
+        {
+            m_Stats.Misses++;
+            m_Stats.Pending++;
+
+            entry = std::make_unique<Entry<T>>();
+            entry->Future = entry->Promise.get_future().share();
+        }
+        else
+        {
+            m_Stats.Hits++;
+        }
+
+        return *entry;
+    }
+
+    template<typename T, typename CreateFunction>
+    void PipelineLibrary::compile(Entry<T>& entry, uint64_t hash, const char* kind, CreateFunction&& create)
+    {
+        // nvrhi resource creation is thread-safe; entries are only freed after destroy() has waited for this job
+        JobSystem::run([this, entry = &entry, hash, kind, create = std::forward<CreateFunction>(create)]()
+        {
+            SIL_PROFILE_SCOPE("Compile Pipeline");
+
+            auto start = std::chrono::steady_clock::now();
+            T pipeline = create(m_Device);
+            double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            if (pipeline)
+                SIL_DEBUG_LOG("Compiled {} pipeline {:016x} in {:.2f} ms", kind, hash, milliseconds);
+            else
+                SIL_ERROR("Failed to compile {} pipeline {:016x}", kind, hash);
+
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_Stats.Pending--;
+                if (!pipeline)
+                    m_Stats.Failures++;
+                m_Stats.TotalCompileMilliseconds += milliseconds;
+                m_Stats.MaxCompileMilliseconds = std::max(m_Stats.MaxCompileMilliseconds, milliseconds);
+            }
+
+            entry->Pipeline = pipeline;
+            entry->Ready.store(true, std::memory_order_release);
+            entry->Promise.set_value(std::move(pipeline));
+        }, &m_PendingCompiles);
+    }
+
+}
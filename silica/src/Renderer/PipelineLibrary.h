@@ -0,0 +1,88 @@
+#pragma once
+
+#include "Device.h"
+#include "Core/JobSystem.h"
+
+#include <nvrhi/nvrhi.h>
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace silica {
+
+    // Pipelines keyed by a hash of their full description: shader bytecode and entry points,
+    // render state, input layout, binding layouts and framebuffer formats. Misses are compiled
+    // on the job system so the thread asking for a pipeline never waits for the driver.
+    class PipelineLibrary
+    {
+    public:
+        PipelineLibrary() = default;
+        ~PipelineLibrary() = default;
+
+        void create(nvrhi::IDevice* device);
+        // waits for compiles still in flight and releases every pipeline
+        void destroy();
+
+        // nullptr until the pipeline has been compiled
+        nvrhi::IGraphicsPipeline* getGraphicsPipeline(const nvrhi::GraphicsPipelineDesc& desc, nvrhi::IFramebuffer* framebuffer);
+        nvrhi::IComputePipeline* getComputePipeline(const nvrhi::ComputePipelineDesc& desc);
+
+        // for callers that can block, e.g. while loading; the result is null if compilation failed
+        std::shared_future<nvrhi::GraphicsPipelineHandle> requestGraphicsPipeline(const nvrhi::GraphicsPipelineDesc& desc, nvrhi::IFramebuffer* framebuffer);
+        std::shared_future<nvrhi::ComputePipelineHandle> requestComputePipeline(const nvrhi::ComputePipelineDesc& desc);
+
+        void waitForPending();
+
+        PipelineLibraryStats getStats() const;
+
+        // stable across runs as long as the shaders and states are the same
+        uint64_t hashGraphicsPipeline(const nvrhi::GraphicsPipelineDesc& desc, const nvrhi::FramebufferInfo& framebufferInfo);
+        uint64_t hashComputePipeline(const nvrhi::ComputePipelineDesc& desc);
+    private:
+        template<typename T>
+        struct Entry
+        {
+            T Pipeline;
+            std::atomic<bool> Ready = false;
+            std::promise<T> Promise;
+            std::shared_future<T> Future;
+        };
+
+        template<typename T>
+        using EntryMap = std::unordered_map<uint64_t, std::unique_ptr<Entry<T>>>;
+
+        // bytecode hashes are cached per shader object so lookups do not rehash every frame
+        uint64_t hashShader(nvrhi::IShader* shader);
+
+        Entry<nvrhi::GraphicsPipelineHandle>& getGraphicsEntry(const nvrhi::GraphicsPipelineDesc& desc, nvrhi::IFramebuffer* framebuffer);
+        Entry<nvrhi::ComputePipelineHandle>& getComputeEntry(const nvrhi::ComputePipelineDesc& desc);
+
+        template<typename T>
+        Entry<T>& findOrInsert(EntryMap<T>& entries, uint64_t hash, bool& inserted);
+        template<typename T, typename CreateFunction>
+        void compile(Entry<T>& entry, uint64_t hash, const char* kind, CreateFunction&& create);
+    private:
+        struct ShaderHash
+        {
+            nvrhi::ShaderHandle Shader;
+            uint64_t Hash = 0;
+        };
+
+        nvrhi::IDevice* m_Device = nullptr;
+
+        EntryMap<nvrhi::GraphicsPipelineHandle> m_GraphicsPipelines;
+        EntryMap<nvrhi::ComputePipelineHandle> m_ComputePipelines;
+
+        std::mutex m_ShaderHashMutex;
+        std::unordered_map<nvrhi::IShader*, ShaderHash> m_ShaderHashes;
+
+        JobCounter m_PendingCompiles;
+        PipelineLibraryStats m_Stats;
+
+        mutable std::mutex m_Mutex;
+    };
+
+}
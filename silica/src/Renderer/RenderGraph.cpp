@@ -0,0 +1,691 @@
+#include "RenderGraph.h"
+
+#include "Core/Assert.h"
+#include "Core/Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace silica {
+
+    namespace utils {
+
+        // cached resources are dropped once they have gone unused for this many graph executions
+        constexpr static uint64_t s_RenderGraphEvictionFrames = 8;
+        constexpr static uint64_t s_RenderGraphHeapGranularity = 1024 * 1024;
+
+        static uint64_t alignUp(uint64_t value, uint64_t alignment)
+        {
+            alignment = std::max<uint64_t>(alignment, 1);
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        // everything that changes the memory layout; debug names and initial states don't
+        static bool isSameTexture(const nvrhi::TextureDesc& a, const nvrhi::TextureDesc& b)
+        {
+            return a.width == b.width && a.height == b.height && a.depth == b.depth && a.arraySize == b.arraySize
+                && a.mipLevels == b.mipLevels && a.sampleCount == b.sampleCount && a.sampleQuality == b.sampleQuality
+                && a.format == b.format && a.dimension == b.dimension && a.isRenderTarget == b.isRenderTarget
+                && a.isUAV == b.isUAV && a.isTypeless == b.isTypeless;
+        }
+
+        static bool isSameBuffer(const nvrhi::BufferDesc& a, const nvrhi::BufferDesc& b)
+        {
+            return a.byteSize == b.byteSize && a.structStride == b.structStride && a.format == b.format
+                && a.canHaveUAVs == b.canHaveUAVs && a.canHaveTypedViews == b.canHaveTypedViews && a.canHaveRawViews == b.canHaveRawViews
+                && a.isVertexBuffer == b.isVertexBuffer && a.isIndexBuffer == b.isIndexBuffer
+                && a.isConstantBuffer == b.isConstantBuffer && a.isDrawIndirectArgs == b.isDrawIndirectArgs;
+        }
+
+    }
+
+    RenderGraphResource RenderGraphBuilder::createTexture(const nvrhi::TextureDesc& desc)
+    {
+        RenderGraph::ResourceEntry entry;
+        entry.IsTexture = true;
+        entry.TextureDesc = desc;
+        entry.TextureDesc.isVirtual = true;
+        entry.TextureDesc.initialState = nvrhi::ResourceStates::Unknown;
+        entry.TextureDesc.keepInitialState = false;
+        return m_Graph.addResource(std::move(entry));
+    }
+
+    RenderGraphResource RenderGraphBuilder::createBuffer(const nvrhi::BufferDesc& desc)
+    {
+        SIL_ASSERT(desc.cpuAccess == nvrhi::CpuAccessMode::None && !desc.isVolatile, "Transient render graph buffers must be GPU-only");
+
+        RenderGraph::ResourceEntry entry;
+        entry.IsTexture = false;
+        entry.BufferDesc = desc;
+        entry.BufferDesc.isVirtual = true;
+        entry.BufferDesc.initialState = nvrhi::ResourceStates::Unknown;
+        entry.BufferDesc.keepInitialState = false;
+        return m_Graph.addResource(std::move(entry));
+    }
+
+    void RenderGraphBuilder::read(RenderGraphResource resource, nvrhi::ResourceStates state)
+    {
+        access(resource, state, false);
+    }
+
+    void RenderGraphBuilder::write(RenderGraphResource resource, nvrhi::ResourceStates state)
+    {
+        access(resource, state, true);
+    }
+
+    void RenderGraphBuilder::setSideEffect()
+    {
+        m_Graph.m_Passes[m_Pass].SideEffect = true;
+    }
+
+    void RenderGraphBuilder::access(RenderGraphResource resource, nvrhi::ResourceStates state, bool write)
+    {
+        SIL_ASSERT(resource.isValid() && resource.Index < m_Graph.m_Resources.size(), "Render graph resource is not from this frame");
+
+        std::vector<RenderGraph::Access>& accesses = m_Graph.m_Passes[m_Pass].Accesses;
+        for (RenderGraph::Access& existing : accesses)
+        {
+            if (existing.Resource == resource.Index)
+            {
+                existing.State = existing.State | state;
+                existing.Read |= !write;
+                existing.Write |= write;
+                return;
+            }
+        }
+
+        accesses.push_back({ resource.Index, state, !write, write });
+    }
+
+    nvrhi::ITexture* RenderGraphContext::getTexture(RenderGraphResource resource) const
+    {
+        return m_Graph.m_Resources[resource.Index].Texture;
+    }
+
+    nvrhi::IBuffer* RenderGraphContext::getBuffer(RenderGraphResource resource) const
+    {
+        return m_Graph.m_Resources[resource.Index].Buffer;
+    }
+
+    void RenderGraph::create(Device* device)
+    {
+        m_Device = device;
+        m_NvrhiDevice = device->getNvrhiDevice<nvrhi::DeviceHandle>().Get();
+
+        if (m_Device->hasDedicatedQueue(nvrhi::CommandQueue::Compute))
+        {
+            nvrhi::CommandListParameters params = nvrhi::CommandListParameters()
+                .setEnableImmediateExecution(false)
+                .setQueueType(nvrhi::CommandQueue::Compute);
+            m_ComputeCommandList = m_NvrhiDevice->createCommandList(params);
+        }
+    }
+
+    void RenderGraph::destroy()
+    {
+        if (!m_Device)
+            return;
+
+        m_Passes.clear();
+        m_Resources.clear();
+
+        for (uint32_t i = 0; i < 2; i++)
+        {
+            m_Device->trackMemory(i == 0 ? MemoryCategory::RenderTarget : MemoryCategory::Buffer, -(int64_t)m_Heaps[i].Capacity);
+            m_Heaps[i] = {};
+        }
+
+        for (AsyncResourceRing& ring : m_AsyncRings)
+        {
+            for (AsyncResource& slot : ring.Slots)
+            {
+                if (slot.Texture || slot.Buffer)
+                    m_Device->trackMemory(ring.IsTexture ? MemoryCategory::RenderTarget : MemoryCategory::Buffer, -(int64_t)ring.SlotBytes);
+            }
+        }
+        m_AsyncRings.clear();
+
+        m_TextureRequirements.clear();
+        m_BufferRequirements.clear();
+        m_ComputeCommandList = nullptr;
+        m_NvrhiDevice = nullptr;
+        m_Device = nullptr;
+    }
+
+    RenderGraphResource RenderGraph::importTexture(nvrhi::ITexture* texture, nvrhi::ResourceStates state)
+    {
+        ResourceEntry entry;
+        entry.IsTexture = true;
+        entry.Imported = true;
+        entry.Texture = texture;
+        entry.ImportedState = state;
+        return addResource(std::move(entry));
+    }
+
+    RenderGraphResource RenderGraph::importBuffer(nvrhi::IBuffer* buffer, nvrhi::ResourceStates state)
+    {
+        ResourceEntry entry;
+        entry.IsTexture = false;
+        entry.Imported = true;
+        entry.Buffer = buffer;
+        entry.ImportedState = state;
+        return addResource(std::move(entry));
+    }
+
+    void RenderGraph::addPass(const char* name, RenderGraphQueue queue, const RenderGraphSetup& setup, RenderGraphExecute execute)
+    {
+        uint32_t index = (uint32_t)m_Passes.size();
+
+        Pass& pass = m_Passes.emplace_back();
+        pass.Name = name;
+        pass.Queue = queue;
+        pass.Execute = std::move(execute);
+
+        RenderGraphBuilder builder(*this, index);
+        setup(builder);
+    }
+
+    void RenderGraph::execute()
+    {
+        SIL_PROFILE_FUNCTION();
+
+        m_FrameCounter++;
+        m_Stats = {};
+        m_Stats.Passes = (uint32_t)m_Passes.size();
+
+        cull();
+        schedule();
+        placeTransients(true);
+        placeTransients(false);
+
+        for (ResourceEntry& resource : m_Resources)
+        {
+            if (resource.Async)
+                resolveAsyncResource(resource);
+        }
+
+        evictStale();
+
+        m_Stats.PassTimings.reserve(m_Passes.size() - m_Stats.CulledPasses);
+
+        // the compute queue is submitted ahead of the frame's graphics batch, which waits for it
+        if (m_Stats.AsyncComputePasses > 0)
+        {
+            m_ComputeCommandList->open();
+
+            for (ResourceEntry& resource : m_Resources)
+            {
+                if (!resource.Async)
+                    continue;
+
+                if (resource.IsTexture)
+                    m_ComputeCommandList->beginTrackingTextureState(resource.Texture, nvrhi::AllSubresources, nvrhi::ResourceStates::Unknown);
+                else
+                    m_ComputeCommandList->beginTrackingBufferState(resource.Buffer, nvrhi::ResourceStates::Unknown);
+                resource.State = nvrhi::ResourceStates::Unknown;
+            }
+
+            for (Pass& pass : m_Passes)
+            {
+                if (!pass.Culled && pass.Async)
+                    recordPass(pass, m_ComputeCommandList, false);
+            }
+
+            m_ComputeCommandList->close();
+            m_Device->submitCommandList(m_ComputeCommandList);
+        }
+
+        nvrhi::ICommandList* commandList = m_Device->beginCommandList();
+
+        bool hasPlacedResources = false;
+        for (ResourceEntry& resource : m_Resources)
+        {
+            // async resources continue from the state the compute list left them in; placed ones start undefined
+            if (resource.Imported)
+            {
+                resource.State = resource.ImportedState;
+            }
+            else if (resource.Async)
+            {
+                if (!resource.UsedByGraphics)
+                    continue;
+            }
+            else
+            {
+                if (resource.FirstPass == ~0u)
+                    continue;
+
+                resource.State = nvrhi::ResourceStates::Unknown;
+                hasPlacedResources = true;
+            }
+
+            if (resource.IsTexture)
+                commandList->beginTrackingTextureState(resource.Texture, nvrhi::AllSubresources, resource.State);
+            else
+                commandList->beginTrackingBufferState(resource.Buffer, resource.State);
+        }
+
+        // the heaps were used by other resources in earlier frames, so their first use waits for everything before it
+        bool aliasingBarrier = hasPlacedResources;
+        for (Pass& pass : m_Passes)
+        {
+            if (pass.Culled || pass.Async)
+                continue;
+
+            if (aliasingBarrier || pass.NeedsAliasingBarrier)
+            {
+                m_Device->aliasingBarrier(commandList);
+                m_Stats.AliasingBarriers++;
+                aliasingBarrier = false;
+            }
+
+            recordPass(pass, commandList, true);
+        }
+
+        for (ResourceEntry& resource : m_Resources)
+        {
+            if (resource.Imported)
+                transition(resource, commandList, resource.ImportedState);
+        }
+        commandList->commitBarriers();
+
+        m_Device->endCommandList(commandList);
+
+        m_Passes.clear();
+        m_Resources.clear();
+        m_LastStats = std::move(m_Stats);
+    }
+
+    RenderGraphResource RenderGraph::addResource(ResourceEntry&& entry)
+    {
+        m_Resources.push_back(std::move(entry));
+        return { (uint32_t)m_Resources.size() - 1 };
+    }
+
+    void RenderGraph::cull()
+    {
+        // walking backwards, a pass survives if it writes something a surviving pass reads (or that outlives the graph)
+        std::vector<bool> needed(m_Resources.size());
+        for (size_t i = 0; i < m_Resources.size(); i++)
+            needed[i] = m_Resources[i].Imported;
+
+        for (size_t i = m_Passes.size(); i-- > 0;)
+        {
+            Pass& pass = m_Passes[i];
+
+            bool live = pass.SideEffect;
+            for (const Access& access : pass.Accesses)
+                live |= access.Write && needed[access.Resource];
+
+            pass.Culled = !live;
+            if (!live)
+            {
+                m_Stats.CulledPasses++;
+                continue;
+            }
+
+            for (const Access& access : pass.Accesses)
+            {
+                if (access.Read)
+                    needed[access.Resource] = true;
+            }
+        }
+    }
+
+    void RenderGraph::schedule()
+    {
+        // compute work runs before the frame's graphics work, so an async pass can't depend on anything graphics
+        // touched earlier in the frame. Imported resources stay on graphics since earlier frames may still use them
+        std::vector<bool> touchedByGraphics(m_Resources.size());
+
+        for (uint32_t i = 0; i < (uint32_t)m_Passes.size(); i++)
+        {
+            Pass& pass = m_Passes[i];
+            if (pass.Culled)
+                continue;
+
+            bool async = m_ComputeCommandList && pass.Queue == RenderGraphQueue::AsyncCompute;
+            for (const Access& access : pass.Accesses)
+                async &= !m_Resources[access.Resource].Imported && !touchedByGraphics[access.Resource];
+
+            pass.Async = async;
+            if (async)
+                m_Stats.AsyncComputePasses++;
+
+            for (const Access& access : pass.Accesses)
+            {
+                ResourceEntry& resource = m_Resources[access.Resource];
+                resource.FirstPass = std::min(resource.FirstPass, i);
+                resource.LastPass = std::max(resource.LastPass, i);
+
+                if (async)
+                {
+                    resource.Async = true;
+                }
+                else
+                {
+                    touchedByGraphics[access.Resource] = true;
+                    resource.UsedByGraphics = true;
+                }
+            }
+        }
+    }
+
+    void RenderGraph::placeTransients(bool textures)
+    {
+        SIL_PROFILE_FUNCTION();
+
+        std::vector<uint32_t> order;
+        for (uint32_t i = 0; i < (uint32_t)m_Resources.size(); i++)
+        {
+            ResourceEntry& resource = m_Resources[i];
+            if (resource.Imported || resource.Async || resource.IsTexture != textures || resource.FirstPass == ~0u)
+                continue;
+
+            resource.Requirements = getRequirements(resource);
+            order.push_back(i);
+
+            m_Stats.TransientResources++;
+            m_Stats.TransientBytes += resource.Requirements.size;
+        }
+
+        if (order.empty())
+            return;
+
+        // largest first, each at the lowest offset not used by a resource alive at the same time
+        std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b)
+        {
+            const ResourceEntry& left = m_Resources[a];
+            const ResourceEntry& right = m_Resources[b];
+            return left.Requirements.size != right.Requirements.size ? left.Requirements.size > right.Requirements.size : left.FirstPass < right.FirstPass;
+        });
+
+        std::vector<uint32_t> placed;
+        std::vector<std::pair<uint64_t, uint64_t>> ranges;
+        uint64_t required = 0;
+
+        for (uint32_t index : order)
+        {
+            ResourceEntry& resource = m_Resources[index];
+
+            ranges.clear();
+            for (uint32_t other : placed)
+            {
+                const ResourceEntry& entry = m_Resources[other];
+                if (entry.FirstPass <= resource.LastPass && resource.FirstPass <= entry.LastPass)
+                    ranges.push_back({ entry.Offset, entry.Offset + entry.Requirements.size });
+            }
+            std::sort(ranges.begin(), ranges.end());
+
+            uint64_t offset = 0;
+            for (const auto& [begin, end] : ranges)
+            {
+                if (utils::alignUp(offset, resource.Requirements.alignment) + resource.Requirements.size <= begin)
+                    break;
+                offset = std::max(offset, end);
+            }
+
+            resource.Offset = utils::alignUp(offset, resource.Requirements.alignment);
+            required = std::max(required, resource.Offset + resource.Requirements.size);
+            placed.push_back(index);
+        }
+
+        // a resource starting over memory that an earlier one used this frame has to wait for that use to finish
+        for (uint32_t index : placed)
+        {
+            ResourceEntry& resource = m_Resources[index];
+            for (uint32_t other : placed)
+            {
+                const ResourceEntry& entry = m_Resources[other];
+                if (entry.LastPass < resource.FirstPass && entry.Offset < resource.Offset + resource.Requirements.size && resource.Offset < entry.Offset + entry.Requirements.size)
+                {
+                    m_Passes[resource.FirstPass].NeedsAliasingBarrier = true;
+                    break;
+                }
+            }
+        }
+
+        m_Stats.AliasedBytes += required;
+
+        AliasingHeap& heap = m_Heaps[textures ? 0 : 1];
+        if (required > heap.Capacity)
+        {
+            uint64_t capacity = utils::alignUp(std::max(required, heap.Capacity + heap.Capacity / 2), utils::s_RenderGraphHeapGranularity);
+            releaseHeap(heap, textures);
+
+            nvrhi::HeapDesc heapDesc = nvrhi::HeapDesc()
+                .setCapacity(capacity)
+                .setType(nvrhi::HeapType::DeviceLocal)
+                .setDebugName(textures ? "Render Graph Textures" : "Render Graph Buffers");
+
+            heap.Heap = m_NvrhiDevice->createHeap(heapDesc);
+            SIL_ASSERT_OR_ERROR(heap.Heap, "Failed to create a {} MiB render graph heap", capacity >> 20);
+            heap.Capacity = capacity;
+
+            m_Device->trackMemory(textures ? MemoryCategory::RenderTarget : MemoryCategory::Buffer, (int64_t)capacity);
+            SIL_DEBUG_LOG("Render graph {} heap grew to {} MiB", textures ? "texture" : "buffer", capacity >> 20);
+        }
+
+        for (uint32_t index : placed)
+        {
+            ResourceEntry& resource = m_Resources[index];
+
+            CachedResource* cached = nullptr;
+            for (CachedResource& candidate : heap.Resources)
+            {
+                if (candidate.Offset != resource.Offset || candidate.LastUsedFrame == m_FrameCounter)
+                    continue;
+
+                bool match = textures ? utils::isSameTexture(candidate.Texture->getDesc(), resource.TextureDesc) : utils::isSameBuffer(candidate.Buffer->getDesc(), resource.BufferDesc);
+                if (match)
+                {
+                    cached = &candidate;
+                    break;
+                }
+            }
+
+            if (!cached)
+            {
+                CachedResource created;
+                created.Offset = resource.Offset;
+                if (textures)
+                {
+                    created.Texture = m_NvrhiDevice->createTexture(resource.TextureDesc);
+                    m_NvrhiDevice->bindTextureMemory(created.Texture, heap.Heap, resource.Offset);
+                }
+                else
+                {
+                    created.Buffer = m_NvrhiDevice->createBuffer(resource.BufferDesc);
+                    m_NvrhiDevice->bindBufferMemory(created.Buffer, heap.Heap, resource.Offset);
+                }
+
+                heap.Resources.push_back(std::move(created));
+                cached = &heap.Resources.back();
+            }
+
+            cached->LastUsedFrame = m_FrameCounter;
+            resource.Texture = cached->Texture;
+            resource.Buffer = cached->Buffer;
+        }
+    }
+
+    void RenderGraph::resolveAsyncResource(ResourceEntry& resource)
+    {
+        AsyncResourceRing* ring = nullptr;
+        for (AsyncResourceRing& candidate : m_AsyncRings)
+        {
+            if (candidate.IsTexture != resource.IsTexture || candidate.LastUsedFrame == m_FrameCounter)
+                continue;
+
+            if (resource.IsTexture ? utils::isSameTexture(candidate.TextureDesc, resource.TextureDesc) : utils::isSameBuffer(candidate.BufferDesc, resource.BufferDesc))
+            {
+                ring = &candidate;
+                break;
+            }
+        }
+
+        if (!ring)
+        {
+            ring = &m_AsyncRings.emplace_back();
+            ring->IsTexture = resource.IsTexture;
+            ring->TextureDesc = resource.TextureDesc;
+            ring->TextureDesc.isVirtual = false;
+            ring->BufferDesc = resource.BufferDesc;
+            ring->BufferDesc.isVirtual = false;
+            ring->Slots.resize(m_Device->getFramesInFlight());
+        }
+
+        ring->LastUsedFrame = m_FrameCounter;
+
+        // the slot was last used framesInFlight frames ago, which beginFrame has already waited for
+        uint64_t gpuValue = m_Device->getCurrentFrameGpuValue();
+        AsyncResource& slot = ring->Slots[gpuValue % ring->Slots.size()];
+        if (slot.GpuValue > m_Device->getCompletedGpuValue())
+            m_Device->waitForGpuValue(slot.GpuValue);
+
+        if (!slot.Texture && !slot.Buffer)
+        {
+            if (ring->IsTexture)
+            {
+                slot.Texture = m_NvrhiDevice->createTexture(ring->TextureDesc);
+                ring->SlotBytes = m_NvrhiDevice->getTextureMemoryRequirements(slot.Texture).size;
+            }
+            else
+            {
+                slot.Buffer = m_NvrhiDevice->createBuffer(ring->BufferDesc);
+                ring->SlotBytes = m_NvrhiDevice->getBufferMemoryRequirements(slot.Buffer).size;
+            }
+
+            m_Device->trackMemory(ring->IsTexture ? MemoryCategory::RenderTarget : MemoryCategory::Buffer, (int64_t)ring->SlotBytes);
+        }
+
+        slot.GpuValue = gpuValue;
+        resource.Texture = slot.Texture;
+        resource.Buffer = slot.Buffer;
+    }
+
+    void RenderGraph::evictStale()
+    {
+        for (uint32_t i = 0; i < 2; i++)
+        {
+            std::vector<CachedResource>& resources = m_Heaps[i].Resources;
+            auto it = std::remove_if(resources.begin(), resources.end(), [this](CachedResource& cached)
+            {
+                if (cached.LastUsedFrame + utils::s_RenderGraphEvictionFrames > m_FrameCounter)
+                    return false;
+
+                m_Device->deferRelease([texture = std::move(cached.Texture), buffer = std::move(cached.Buffer)]() {});
+                return true;
+            });
+            resources.erase(it, resources.end());
+        }
+
+        auto it = std::remove_if(m_AsyncRings.begin(), m_AsyncRings.end(), [this](AsyncResourceRing& ring)
+        {
+            if (ring.LastUsedFrame + utils::s_RenderGraphEvictionFrames > m_FrameCounter)
+                return false;
+
+            for (AsyncResource& slot : ring.Slots)
+            {
+                if (!slot.Texture && !slot.Buffer)
+                    continue;
+
+                m_Device->trackMemory(ring.IsTexture ? MemoryCategory::RenderTarget : MemoryCategory::Buffer, -(int64_t)ring.SlotBytes);
+                m_Device->deferRelease([texture = std::move(slot.Texture), buffer = std::move(slot.Buffer)]() {});
+            }
+            return true;
+        });
+        m_AsyncRings.erase(it, m_AsyncRings.end());
+    }
+
+    void RenderGraph::releaseHeap(AliasingHeap& heap, bool textures)
+    {
+        if (!heap.Heap)
+            return;
+
+        m_Device->trackMemory(textures ? MemoryCategory::RenderTarget : MemoryCategory::Buffer, -(int64_t)heap.Capacity);
+
+        // earlier frames may still be using the heap; the resources go first since they are bound to it
+        m_Device->deferRelease([resources = std::move(heap.Resources), memory = std::move(heap.Heap)]() mutable
+        {
+            resources.clear();
+            memory = nullptr;
+        });
+
+        heap = {};
+    }
+
+    const nvrhi::MemoryRequirements& RenderGraph::getRequirements(const ResourceEntry& resource)
+    {
+        // a virtual resource is never bound or used by the GPU, so the probe can be dropped right away
+        if (resource.IsTexture)
+        {
+            for (const auto& [desc, requirements] : m_TextureRequirements)
+            {
+                if (utils::isSameTexture(desc, resource.TextureDesc))
+                    return requirements;
+            }
+
+            nvrhi::TextureHandle probe = m_NvrhiDevice->createTexture(resource.TextureDesc);
+            return m_TextureRequirements.emplace_back(resource.TextureDesc, m_NvrhiDevice->getTextureMemoryRequirements(probe)).second;
+        }
+
+        for (const auto& [desc, requirements] : m_BufferRequirements)
+        {
+            if (utils::isSameBuffer(desc, resource.BufferDesc))
+                return requirements;
+        }
+
+        nvrhi::BufferHandle probe = m_NvrhiDevice->createBuffer(resource.BufferDesc);
+        return m_BufferRequirements.emplace_back(resource.BufferDesc, m_NvrhiDevice->getBufferMemoryRequirements(probe)).second;
+    }
+
+    void RenderGraph::recordPass(Pass& pass, nvrhi::ICommandList* commandList, bool graphics)
+    {
+        SIL_PROFILE_SCOPE(pass.Name);
+
+        auto start = std::chrono::steady_clock::now();
+
+        uint32_t transitions = m_Stats.Transitions;
+        for (const Access& access : pass.Accesses)
+            transition(m_Resources[access.Resource], commandList, access.State);
+
+        if (m_Stats.Transitions != transitions)
+        {
+            commandList->commitBarriers();
+            m_Stats.BarrierBatches++;
+        }
+
+        RenderGraphContext context(*this, commandList);
+        if (graphics)
+        {
+            // timestamp queries are reset and resolved on the graphics queue, so compute passes only get CPU timings
+            SIL_GPU_SCOPE(*m_Device, commandList, pass.Name);
+            pass.Execute(context);
+        }
+        else
+        {
+            pass.Execute(context);
+        }
+
+        double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        m_Stats.PassTimings.push_back({ pass.Name, milliseconds, pass.Async });
+    }
+
+    void RenderGraph::transition(ResourceEntry& resource, nvrhi::ICommandList* commandList, nvrhi::ResourceStates state)
+    {
+        // repeated UAV access still needs a barrier between the writes
+        bool unorderedAccess = (state & nvrhi::ResourceStates::UnorderedAccess) != 0;
+        if (resource.State == state && !unorderedAccess)
+            return;
+
+        if (resource.IsTexture)
+            commandList->setTextureState(resource.Texture, nvrhi::AllSubresources, state);
+        else
+            commandList->setBufferState(resource.Buffer, state);
+
+        resource.State = state;
+        m_Stats.Transitions++;
+    }
+
+}
@@ -0,0 +1,242 @@
+#pragma once
+
+#include "Device.h"
+
+#include <nvrhi/nvrhi.h>
+
+#include <functional>
+#include <vector>
+
+namespace silica {
+
+    class RenderGraph;
+
+    // index into the graph's resource table, only valid for the frame it was created in
+    struct RenderGraphResource
+    {
+        static constexpr uint32_t InvalidIndex = ~0u;
+
+        uint32_t Index = InvalidIndex;
+
+        bool isValid() const { return Index != InvalidIndex; }
+    };
+
+    enum class RenderGraphQueue
+    {
+        Graphics = 0,
+        // runs on the compute queue ahead of the frame's graphics work when its inputs allow it, otherwise on graphics
+        AsyncCompute
+    };
+
+    struct RenderGraphPassTiming
+    {
+        const char* Name = nullptr;
+        double CpuMilliseconds = 0.0;
+        bool AsyncCompute = false;
+    };
+
+    struct RenderGraphStats
+    {
+        uint32_t Passes = 0;
+        uint32_t CulledPasses = 0;
+        uint32_t AsyncComputePasses = 0;
+        // state transitions requested from nvrhi and the commitBarriers calls they were batched into
+        uint32_t Transitions = 0;
+        uint32_t BarrierBatches = 0;
+        uint32_t AliasingBarriers = 0;
+        uint32_t TransientResources = 0;
+        // what the transient resources would need without aliasing, and what the shared heaps hold
+        uint64_t TransientBytes = 0;
+        uint64_t AliasedBytes = 0;
+        std::vector<RenderGraphPassTiming> PassTimings;
+    };
+
+    class RenderGraphBuilder
+    {
+    public:
+        // transient: memory is only valid within the passes that use it and is shared with resources whose lifetimes don't overlap
+        RenderGraphResource createTexture(const nvrhi::TextureDesc& desc);
+        RenderGraphResource createBuffer(const nvrhi::BufferDesc& desc);
+
+        // states of several accesses to the same resource within a pass are combined
+        void read(RenderGraphResource resource, nvrhi::ResourceStates state = nvrhi::ResourceStates::ShaderResource);
+        void write(RenderGraphResource resource, nvrhi::ResourceStates state);
+
+        // never culled, e.g. for readbacks whose results are consumed outside the graph
+        void setSideEffect();
+    private:
+        RenderGraphBuilder(RenderGraph& graph, uint32_t pass)
+            : m_Graph(graph), m_Pass(pass)
+        {
+        }
+
+        void access(RenderGraphResource resource, nvrhi::ResourceStates state, bool write);
+    private:
+        RenderGraph& m_Graph;
+        uint32_t m_Pass;
+
+        friend class RenderGraph;
+    };
+
+    class RenderGraphContext
+    {
+    public:
+        nvrhi::ICommandList* getCommandList() const { return m_CommandList; }
+        nvrhi::ITexture* getTexture(RenderGraphResource resource) const;
+        nvrhi::IBuffer* getBuffer(RenderGraphResource resource) const;
+    private:
+        RenderGraphContext(const RenderGraph& graph, nvrhi::ICommandList* commandList)
+            : m_Graph(graph), m_CommandList(commandList)
+        {
+        }
+    private:
+        const RenderGraph& m_Graph;
+        nvrhi::ICommandList* m_CommandList;
+
+        friend class RenderGraph;
+    };
+
+    using RenderGraphSetup = std::function<void(RenderGraphBuilder&)>;
+    using RenderGraphExecute = std::function<void(RenderGraphContext&)>;
+
+    // Frame graph recorded between Device::beginFrame and endFrame. Passes declare what they read and
+    // write; execute() culls passes nothing depends on, moves async compute passes to the compute queue
+    // when they only depend on other compute work, places transient resources into shared heaps by
+    // lifetime and records every pass with its transitions batched in front of it.
+    class RenderGraph
+    {
+    public:
+        RenderGraph() = default;
+        ~RenderGraph() = default;
+
+        void create(Device* device);
+        // the GPU must be idle
+        void destroy();
+
+        // the resource is expected in this state when the graph starts and is put back into it at the end
+        RenderGraphResource importTexture(nvrhi::ITexture* texture, nvrhi::ResourceStates state);
+        RenderGraphResource importBuffer(nvrhi::IBuffer* buffer, nvrhi::ResourceStates state);
+
+        // setup runs immediately; the name has to outlive the frame since the profiler keeps the pointer
+        void addPass(const char* name, RenderGraphQueue queue, const RenderGraphSetup& setup, RenderGraphExecute execute);
+        void addPass(const char* name, const RenderGraphSetup& setup, RenderGraphExecute execute) { addPass(name, RenderGraphQueue::Graphics, setup, std::move(execute)); }
+
+        // records and submits this frame's passes, then clears them
+        void execute();
+
+        const RenderGraphStats& getLastStats() const { return m_LastStats; }
+    private:
+        struct Access
+        {
+            uint32_t Resource = 0;
+            nvrhi::ResourceStates State = nvrhi::ResourceStates::Unknown;
+            bool Read = false;
+            bool Write = false;
+        };
+
+        struct Pass
+        {
+            const char* Name = nullptr;
+            RenderGraphQueue Queue = RenderGraphQueue::Graphics;
+            RenderGraphExecute Execute;
+            std::vector<Access> Accesses;
+            bool SideEffect = false;
+            bool Culled = false;
+            bool Async = false;
+            // a transient resource placed over memory an earlier one used this frame starts here
+            bool NeedsAliasingBarrier = false;
+        };
+
+        struct ResourceEntry
+        {
+            bool IsTexture = true;
+            bool Imported = false;
+            nvrhi::TextureDesc TextureDesc;
+            nvrhi::BufferDesc BufferDesc;
+            nvrhi::TextureHandle Texture;
+            nvrhi::BufferHandle Buffer;
+            nvrhi::ResourceStates ImportedState = nvrhi::ResourceStates::Unknown;
+
+            // touched by a pass running on the compute queue; such resources get a copy per frame in flight instead of aliasing
+            bool Async = false;
+            bool UsedByGraphics = false;
+            // first and last live pass, in declaration order
+            uint32_t FirstPass = ~0u;
+            uint32_t LastPass = 0;
+
+            nvrhi::MemoryRequirements Requirements;
+            uint64_t Offset = 0;
+
+            nvrhi::ResourceStates State = nvrhi::ResourceStates::Unknown;
+        };
+
+        // placed resources are kept across frames and reused while their description and offset stay the same
+        struct CachedResource
+        {
+            nvrhi::TextureHandle Texture;
+            nvrhi::BufferHandle Buffer;
+            uint64_t Offset = 0;
+            uint64_t LastUsedFrame = 0;
+        };
+
+        struct AliasingHeap
+        {
+            nvrhi::HeapHandle Heap;
+            uint64_t Capacity = 0;
+            std::vector<CachedResource> Resources;
+        };
+
+        // transient resources used by async compute, one per frame in flight
+        struct AsyncResource
+        {
+            nvrhi::TextureHandle Texture;
+            nvrhi::BufferHandle Buffer;
+            uint64_t GpuValue = 0;
+        };
+
+        struct AsyncResourceRing
+        {
+            nvrhi::TextureDesc TextureDesc;
+            nvrhi::BufferDesc BufferDesc;
+            bool IsTexture = true;
+            std::vector<AsyncResource> Slots;
+            // charged to the memory budget per created slot
+            uint64_t SlotBytes = 0;
+            uint64_t LastUsedFrame = 0;
+        };
+
+        RenderGraphResource addResource(ResourceEntry&& entry);
+
+        void cull();
+        void schedule();
+        void placeTransients(bool textures);
+        void resolveAsyncResource(ResourceEntry& resource);
+        void evictStale();
+        void releaseHeap(AliasingHeap& heap, bool textures);
+
+        const nvrhi::MemoryRequirements& getRequirements(const ResourceEntry& resource);
+        void recordPass(Pass& pass, nvrhi::ICommandList* commandList, bool graphics);
+        void transition(ResourceEntry& resource, nvrhi::ICommandList* commandList, nvrhi::ResourceStates state);
+    private:
+        Device* m_Device = nullptr;
+        nvrhi::IDevice* m_NvrhiDevice = nullptr;
+        nvrhi::CommandListHandle m_ComputeCommandList;
+
+        std::vector<Pass> m_Passes;
+        std::vector<ResourceEntry> m_Resources;
+
+        // [0] textures, [1] buffers; they never share a heap so bufferImageGranularity can't be violated
+        AliasingHeap m_Heaps[2];
+        std::vector<AsyncResourceRing> m_AsyncRings;
+        std::vector<std::pair<nvrhi::TextureDesc, nvrhi::MemoryRequirements>> m_TextureRequirements;
+        std::vector<std::pair<nvrhi::BufferDesc, nvrhi::MemoryRequirements>> m_BufferRequirements;
+
+        uint64_t m_FrameCounter = 0;
+        RenderGraphStats m_Stats;
+        RenderGraphStats m_LastStats;
+
+        friend class RenderGraphBuilder;
+        friend class RenderGraphContext;
+    };
+
+}
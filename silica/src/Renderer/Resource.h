@@ -1,6 +1,8 @@
 #pragma once
 
 #include <memory>
+#include <atomic>
+#include <cstdint>
 
 namespace silica {
 
@@ -10,14 +12,25 @@ namespace silica {
         virtual ~Resource() = default;
         
         bool isValid() const noexcept { return m_Valid; }
+
+        // GPU value (Device::getCurrentFrameGpuValue) of the last frame that used the resource, so a
+        // deferred release can retire it before the current frame. Zero means the current frame
+        void markUsed(uint64_t gpuValue) noexcept
+        {
+            uint64_t previous = m_LastUsedGpuValue.load(std::memory_order_relaxed);
+            while (previous < gpuValue && !m_LastUsedGpuValue.compare_exchange_weak(previous, gpuValue, std::memory_order_relaxed));
+        }
+        uint64_t getLastUsedGpuValue() const noexcept { return m_LastUsedGpuValue.load(std::memory_order_relaxed); }
     protected:
         virtual void destroy() {}
         virtual void invalidate() noexcept {}
     protected:
         bool m_Valid = true;
+        std::atomic<uint64_t> m_LastUsedGpuValue = 0;
         
         friend class VulkanInstance;
         friend class VulkanDevice;
+        friend class VulkanReleaseQueue;
     };
 
 }
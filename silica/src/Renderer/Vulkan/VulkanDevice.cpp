@@ -1,5 +1,7 @@
 #include "VulkanDevice.h"
 
+#include "Core/Profiler.h"
+
 #include <nvrhi/nvrhi.h>
 #include <nvrhi/vulkan.h>
 #include <vulkan/vulkan.hpp>
@@ -7,6 +9,9 @@
 #include <set>
 #include <string>
 #include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <format>
 
 namespace vk::detail {
     DispatchLoaderDynamic defaultDispatchLoaderDynamic;
@@ -25,65 +30,56 @@ namespace silica {
         "VK_LAYER_KHRONOS_validation"
     };    
 
-    const static std::vector<const char*> s_DeviceExtensions = {
-        VK_KHR_SWAPCHAIN_EXTENSION_NAME,
-#ifdef SIL_PLATFORM_MAC
-        "VK_KHR_portability_subset"
-#endif
-    };
-
     namespace utils {
 
-        QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device, VkSurfaceKHR surface)
+        static std::vector<const char*> getRequiredDeviceExtensions(bool headless)
         {
-            QueueFamilyIndices indices{};
+            std::vector<const char*> extensions;
 
-            uint32_t queueFamilyCount = 0;
-            vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
-
-            std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
-            vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
+            if (!headless)
+                extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
 
-            int i = 0;
-            for (const auto& queueFamily : queueFamilies)
-            {
-                if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
-                    indices.GraphicsFamily = i;
-
-                VkBool32 presentSupport = VK_FALSE;
-                vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
-
-                if (presentSupport)
-                    indices.PresentFamily = i;
-
-                if (indices.isComplete())
-                    break;
-
-                i++;
-            }
+#ifdef SIL_PLATFORM_MAC
+            extensions.push_back("VK_KHR_portability_subset");
+#endif
 
-            return indices;
+            return extensions;
         }
 
-        static bool checkDeviceExtensionSupport(VkPhysicalDevice device)
+        QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device, VkSurfaceKHR surface, const std::vector<VkQueueFamilyProperties>& queueFamilies)
         {
-            uint32_t extensionCount;
-            vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+            QueueFamilyIndices indices{};
 
-            std::vector<VkExtensionProperties> availableExtensions(extensionCount);
-            vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+            for (uint32_t i = 0; i < (uint32_t)queueFamilies.size(); i++)
+            {
+                const VkQueueFamilyProperties& queueFamily = queueFamilies[i];
 
-            std::set<std::string> requiredExtensions;
+                if (!indices.isComplete())
+                {
+                    if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+                        indices.GraphicsFamily = i;
+
+                    // without a surface nothing is presented, so the graphics queue stands in for present
+                    VkBool32 presentSupport = VK_FALSE;
+                    if (surface)
+                        vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
+                    else
+                        presentSupport = (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0;
+
+                    if (presentSupport)
+                        indices.PresentFamily = i;
+                }
 
-            for (const char* ext : s_DeviceExtensions)
-                requiredExtensions.insert(std::string(ext));
+                if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+                    continue;
 
-            for (const auto& extension : availableExtensions)
-            {
-                requiredExtensions.erase(std::string(extension.extensionName));
+                if ((queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT) && !indices.hasCompute())
+                    indices.ComputeFamily = i;
+                else if ((queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT) && !(queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT) && !indices.hasTransfer())
+                    indices.TransferFamily = i;
             }
 
-            return requiredExtensions.empty();
+            return indices;
         }
 
         SwapchainSupportDetails querySwapchainSupport(VkPhysicalDevice device, VkSurfaceKHR surface)
@@ -128,28 +124,119 @@ namespace silica {
             return 0;
         }
 
-        static bool isDeviceSuitable(VkPhysicalDevice device, VkSurfaceKHR surface)
+        PhysicalDeviceCaps queryPhysicalDeviceCaps(VkPhysicalDevice device, VkSurfaceKHR surface)
         {
-            QueueFamilyIndices indices = findQueueFamilies(device, surface);
+            PhysicalDeviceCaps caps;
+            caps.Device = device;
 
-            bool extensionsSupported = checkDeviceExtensionSupport(device);
-
-            bool swapchainAdequate = false;
-            if (extensionsSupported)
+            vkGetPhysicalDeviceProperties(device, &caps.Properties);
+            vkGetPhysicalDeviceMemoryProperties(device, &caps.MemoryProperties);
+            for (uint32_t i = 0; i < caps.MemoryProperties.memoryHeapCount; i++)
             {
-                SwapchainSupportDetails swapChainSupport = querySwapchainSupport(device, surface);
-                swapchainAdequate = !swapChainSupport.Formats.empty() && !swapChainSupport.PresentModes.empty();
+                if (caps.MemoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+                    caps.DeviceLocalBytes += caps.MemoryProperties.memoryHeaps[i].size;
             }
 
-            VkPhysicalDeviceFeatures supportedFeatures;
-            vkGetPhysicalDeviceFeatures(device, &supportedFeatures);
+            uint32_t queueFamilyCount = 0;
+            vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
+            caps.QueueFamilyProperties.resize(queueFamilyCount);
+            vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, caps.QueueFamilyProperties.data());
+
+            caps.QueueFamilies = findQueueFamilies(device, surface, caps.QueueFamilyProperties);
+
+            caps.Features = std::make_unique<VulkanFeatures>();
+            caps.Features->query(device);
+
+            if (surface && caps.Features->hasExtension(VK_KHR_SWAPCHAIN_EXTENSION_NAME))
+                caps.SwapchainSupport = querySwapchainSupport(device, surface);
+
+            return caps;
+        }
+
+        static bool isDeviceSuitable(const PhysicalDeviceCaps& caps, bool needsSurface, const std::vector<const char*>& extensions)
+        {
+            bool extensionsSupported = std::all_of(extensions.begin(), extensions.end(), [&caps](const char* extension) { return caps.Features->hasExtension(extension); });
+
+            bool swapchainAdequate = !needsSurface || (!caps.SwapchainSupport.Formats.empty() && !caps.SwapchainSupport.PresentModes.empty());
 
             return
-                indices.isComplete() &&
+                caps.QueueFamilies.isComplete() &&
                 extensionsSupported &&
                 swapchainAdequate &&
-                supportedFeatures.sampleRateShading &&
-                supportedFeatures.samplerAnisotropy;
+                caps.Features->hasRequiredFeatures();
+        }
+
+        struct AdapterCandidate
+        {
+            const PhysicalDeviceCaps* Caps = nullptr;
+            uint32_t Index = 0;
+            bool Suitable = false;
+            uint64_t Score = 0;
+        };
+
+        static const char* getDeviceTypeName(VkPhysicalDeviceType type)
+        {
+            switch (type)
+            {
+                case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: return "discrete";
+                case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: return "integrated";
+                case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: return "virtual";
+                case VK_PHYSICAL_DEVICE_TYPE_CPU: return "cpu";
+                default: return "other";
+            }
+        }
+
+        // the device type always wins; VRAM, dedicated queues and fast-path features only order devices of the same type
+        static uint64_t scoreDevice(const AdapterCandidate& candidate, const DeviceCapabilities& capabilities)
+        {
+            uint64_t typeRank = 0;
+            switch (candidate.Caps->Properties.deviceType)
+            {
+                case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: typeRank = 4; break;
+                case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: typeRank = 3; break;
+                case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: typeRank = 2; break;
+                case VK_PHYSICAL_DEVICE_TYPE_CPU: typeRank = 1; break;
+                default: break;
+            }
+
+            uint64_t score = typeRank * 1000000;
+            score += std::min<uint64_t>(candidate.Caps->DeviceLocalBytes / (256 * 1024 * 1024), 1000);
+
+            if (candidate.Caps->QueueFamilies.hasCompute())
+                score += 16;
+            if (candidate.Caps->QueueFamilies.hasTransfer())
+                score += 8;
+
+            const bool features[] = {
+                capabilities.Synchronization2, capabilities.BufferDeviceAddress, capabilities.DescriptorIndexing,
+                capabilities.DynamicRendering, capabilities.MemoryBudget, capabilities.PresentWait
+            };
+            for (bool supported : features)
+                score += supported ? 4 : 0;
+
+            return score;
+        }
+
+        static bool matchesAdapterOverride(const AdapterCandidate& candidate, const DeviceInfo& info)
+        {
+            const VkPhysicalDeviceProperties& properties = candidate.Caps->Properties;
+
+            if (info.AdapterIndex >= 0)
+                return candidate.Index == (uint32_t)info.AdapterIndex;
+
+            if (!info.AdapterName.empty())
+            {
+                auto lower = [](std::string text)
+                {
+                    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+                    return text;
+                };
+
+                return lower(properties.deviceName).find(lower(info.AdapterName)) != std::string::npos;
+            }
+
+            return (info.AdapterVendorID == 0 || properties.vendorID == info.AdapterVendorID)
+                && (info.AdapterDeviceID == 0 || properties.deviceID == info.AdapterDeviceID);
         }
 
         VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats)
@@ -165,16 +252,33 @@ namespace silica {
             return availableFormats[0];
         }
 
-        VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes)
+        static VkPresentModeKHR convertPresentMode(PresentMode mode)
         {
-            for (const auto& availablePresentMode : availablePresentModes)
+            switch (mode)
             {
-                if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
-                {
-                    return availablePresentMode;
-                }
+            case PresentMode::Fifo:        return VK_PRESENT_MODE_FIFO_KHR;
+            case PresentMode::FifoRelaxed: return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+            case PresentMode::Mailbox:     return VK_PRESENT_MODE_MAILBOX_KHR;
+            case PresentMode::Immediate:   return VK_PRESENT_MODE_IMMEDIATE_KHR;
+            default:
+                return VK_PRESENT_MODE_FIFO_KHR;
             }
+        }
+
+        VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes, PresentMode preferred)
+        {
+            std::vector<PresentMode> candidates = { preferred };
+            if (preferred == PresentMode::Immediate)
+                candidates.push_back(PresentMode::Mailbox);
 
+            for (PresentMode candidate : candidates)
+            {
+                VkPresentModeKHR mode = convertPresentMode(candidate);
+                if (std::find(availablePresentModes.begin(), availablePresentModes.end(), mode) != availablePresentModes.end())
+                    return mode;
+            }
+
+            // FIFO is the only mode every implementation must support
             return VK_PRESENT_MODE_FIFO_KHR;
         }
 
@@ -311,15 +415,63 @@ namespace silica {
     }
 
     VulkanDevice::VulkanDevice(VulkanInstance* instance, const DeviceInfo &deviceInfo)
-        : Device(), m_Instance(instance)
+        : Device(), m_Instance(instance), m_Info(deviceInfo), m_Headless(instance->isHeadless())
     {
+        static std::atomic<uint64_t> s_DeviceSerial = 0;
+        m_DeviceSerial = ++s_DeviceSerial;
+
+        m_FramesInFlight = std::clamp(m_Info.FramesInFlight, 1u, (uint32_t)SIL_MAX_FRAMES_IN_FLIGHT);
+        if (m_FramesInFlight != m_Info.FramesInFlight)
+            SIL_WARN("DeviceInfo::FramesInFlight {} is out of range, using {}", m_Info.FramesInFlight, m_FramesInFlight);
+
+        m_DeviceExtensions = utils::getRequiredDeviceExtensions(m_Headless);
+
+        auto startupStart = std::chrono::steady_clock::now();
+        auto phaseStart = startupStart;
+        auto endPhase = [this, &phaseStart](const char* name)
+        {
+            auto now = std::chrono::steady_clock::now();
+            m_StartupStats.Phases.push_back({ name, std::chrono::duration<double, std::milli>(now - phaseStart).count() });
+            phaseStart = now;
+        };
+
         pickPhysicalDevice();
+        endPhase("pick physical device");
         createLogicalDevice();
+        endPhase("create logical device");
+        m_MemoryBudget.create(m_PhysicalDevice, m_Capabilities.MemoryBudget, m_Info.MemoryBudgetThresholds);
+        m_PipelineCache.create(m_Device, m_PhysicalDeviceCaps->Properties, m_Instance->getAllocator(), m_Info.PipelineCachePath);
+        endPhase("load pipeline cache");
         createDispatchLoaderDynamic();
         createNVRHIDevice();
-        createCommandPool();
+        endPhase("create nvrhi device");
         createSyncObjects();
-        createSwapchain();
+
+        m_GpuProfiler.create(m_Device, m_PhysicalDeviceCaps->Properties, m_PhysicalDeviceCaps->QueueFamilyProperties[m_QueueFamilies.GraphicsFamily], m_Instance->getAllocator(), m_FramesInFlight);
+
+        nvrhi::CommandQueue uploadQueue = m_QueueFamilies.hasTransfer() ? nvrhi::CommandQueue::Copy : nvrhi::CommandQueue::Graphics;
+        m_UploadManager.create(m_NvrhiDevice, m_Info.UploadRingSizePerFrame * m_FramesInFlight, m_FramesInFlight, uploadQueue);
+        m_UploadRingBytes = m_Info.UploadRingSizePerFrame * m_FramesInFlight;
+        m_MemoryBudget.track(MemoryCategory::Buffer, (int64_t)m_UploadRingBytes);
+        m_PipelineLibrary.create(m_NvrhiDevice);
+        m_MemoryAllocator.create(m_NvrhiDevice, &m_MemoryBudget, m_Info.MemoryBlockSize, m_Info.TransientMemorySize);
+        if (m_BindlessEnabled)
+            m_BindlessHeap.create(m_NvrhiDevice, m_Info.BindlessCapacity);
+
+        endPhase("create frame resources");
+
+        if (m_Headless)
+            createOffscreenTargets();
+        else
+            m_SwapchainDirty = !createSwapchain();
+        endPhase(m_Headless ? "create offscreen targets" : "create swapchain");
+
+        m_StartupStats.TotalMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startupStart).count();
+
+        std::string phases;
+        for (const DeviceStartupPhase& phase : m_StartupStats.Phases)
+            phases += std::format("{}{} {:.2f} ms", phases.empty() ? "" : ", ", phase.Name, phase.Milliseconds);
+        SIL_INFO("Device created in {:.2f} ms ({})", m_StartupStats.TotalMilliseconds, phases);
     }
 
     VulkanDevice::~VulkanDevice()
@@ -327,55 +479,148 @@ namespace silica {
         destroy();
     }
 
-    void VulkanDevice::beginFrame()
+    bool VulkanDevice::beginFrame()
     {
-        vkWaitForFences(m_Device, 1, &m_InFlightFences[m_FrameIndex], VK_TRUE, std::numeric_limits<uint64_t>::max());
+        SIL_PROFILE_BEGIN_FRAME();
+        SIL_PROFILE_FUNCTION();
+
+        if (!m_Headless)
+        {
+            int width, height;
+            glfwGetFramebufferSize(m_Instance->getWindow(), &width, &height);
+
+            if (width == 0 || height == 0)
+                return false;
+
+            if (m_SwapchainDirty || (uint32_t)width != m_WindowExtent.width || (uint32_t)height != m_WindowExtent.height)
+            {
+                if (!recreateSwapchain())
+                    return false;
+            }
+        }
+
+        // the submission that last used this frame slot, i.e. frame N - framesInFlight
+        waitForGpuValue(m_FrameGpuValues[m_FrameIndex]);
+        updateCompletedGpuValue();
+
+        // command buffers and upload chunks of retired submissions go back to nvrhi's pools
+        m_NvrhiDevice->runGarbageCollection();
+        recycleThreadCommandLists(m_FrameIndex);
+        m_UploadManager.beginFrame(m_FrameIndex, getCompletedGpuValue());
+        m_MemoryAllocator.beginFrame(getCompletedGpuValue());
+        m_BindlessHeap.beginFrame(getCompletedGpuValue());
+
+        m_ReleaseQueue.collect(getCompletedGpuValue());
+        m_GpuProfiler.beginFrame(m_FrameIndex, m_FrameNumber);
+        m_MemoryBudget.update();
+
+        if (m_Headless)
+        {
+            m_SwapchainIndex = (m_SwapchainIndex + 1) % (uint32_t)m_SwapchainImages.size();
+
+            m_CurrentSubmitStats = {};
+            m_CurrentSubmitStats.FrameNumber = m_FrameNumber;
+            return true;
+        }
 
         VkResult result = vkAcquireNextImageKHR(m_Device, m_Swapchain, std::numeric_limits<uint64_t>::max(), m_PresentSemaphores[m_FrameIndex], nullptr, &m_SwapchainIndex);
-        if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
+        if (result == VK_ERROR_OUT_OF_DATE_KHR)
         {
-            return;
+            // a failed acquire signals nothing, so the frame's semaphore and fence can be reused as they are
+            if (!recreateSwapchain())
+                return false;
+
+            result = vkAcquireNextImageKHR(m_Device, m_Swapchain, std::numeric_limits<uint64_t>::max(), m_PresentSemaphores[m_FrameIndex], nullptr, &m_SwapchainIndex);
+            if (result == VK_ERROR_OUT_OF_DATE_KHR)
+            {
+                m_SwapchainDirty = true;
+                return false;
+            }
         }
-        VK_CHECK(result, "failed to acquire Vulkan swapchain image");
 
-        vkResetFences(m_Device, 1, &m_InFlightFences[m_FrameIndex]);
+        // suboptimal images are still acquired and must be presented; recreate on the next frame instead
+        if (result == VK_SUBOPTIMAL_KHR)
+            m_SwapchainDirty = true;
+        else
+            VK_CHECK(result, "failed to acquire Vulkan swapchain image");
+
+        m_CurrentSubmitStats = {};
+        m_CurrentSubmitStats.FrameNumber = m_FrameNumber;
 
         m_NvrhiDevice->queueWaitForSemaphore(nvrhi::CommandQueue::Graphics, m_PresentSemaphores[m_FrameIndex], 0);
+        return true;
     }
 
     void VulkanDevice::endFrame()
     {
-        // present
-        m_NvrhiDevice->queueSignalSemaphore(nvrhi::CommandQueue::Graphics, m_PresentSemaphores[m_FrameIndex], 0);
+        SIL_PROFILE_FUNCTION();
 
-        m_EndOfFrameCommandList->open();
-        m_EndOfFrameCommandList->close();
-        getNvrhiDevice<nvrhi::DeviceHandle>()->executeCommandList(m_EndOfFrameCommandList);
+        uint64_t signalValue = m_SubmittedGpuValue + 1;
 
-        VkCommandBufferBeginInfo beginInfo{};
-        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		beginInfo.flags = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        // the acquire wait was queued in beginFrame; nvrhi attaches all of these to the next submission
+        if (!m_Headless)
+            m_NvrhiDevice->queueSignalSemaphore(nvrhi::CommandQueue::Graphics, m_EndOfFrameSemaphores[m_FrameIndex], 0);
+        m_NvrhiDevice->queueSignalSemaphore(nvrhi::CommandQueue::Graphics, m_TimelineSemaphore, signalValue);
 
-		VkResult result = vkBeginCommandBuffer(m_EndOfFrameCommandBuffers[m_FrameIndex], &beginInfo);
-		VK_CHECK(result, "failed to begin Vulkan command buffer!");
+        std::lock_guard<std::mutex> submitLock(m_SubmitMutex);
 
-        result = vkEndCommandBuffer(m_EndOfFrameCommandBuffers[m_FrameIndex]);
-		VK_CHECK(result, "failed to end Vulkan command buffer!");
+        std::sort(m_PendingCommandLists.begin(), m_PendingCommandLists.end(), [](const PendingCommandList& a, const PendingCommandList& b)
+        {
+            return a.Order != b.Order ? a.Order < b.Order : a.Sequence < b.Sequence;
+        });
 
-        VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+        // uploads go ahead of everything else recorded this frame
+        if (nvrhi::ICommandList* uploadCommandList = m_UploadManager.endFrame(signalValue))
+            m_PendingCommandLists.insert(m_PendingCommandLists.begin(), { uploadCommandList, 0, 0 });
 
-		VkSubmitInfo submit{};
-		submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submit.waitSemaphoreCount = 1;
-		submit.pWaitSemaphores = &m_PresentSemaphores[m_FrameIndex];
-		submit.pWaitDstStageMask = waitStages;
-		submit.commandBufferCount = 1;
-		submit.pCommandBuffers = &m_EndOfFrameCommandBuffers[m_FrameIndex];
-		submit.signalSemaphoreCount = 1;
-		submit.pSignalSemaphores = &m_EndOfFrameSemaphores[m_FrameIndex];
+        m_MemoryAllocator.endFrame(signalValue);
 
-        result = vkQueueSubmit(m_GraphicsQueue, 1, &submit, m_InFlightFences[m_FrameIndex]);
-		VK_CHECK(result, "failed to submit to Vulkan queue!");
+        for (nvrhi::CommandQueue queue : { nvrhi::CommandQueue::Copy, nvrhi::CommandQueue::Compute })
+        {
+            m_SubmitScratch.clear();
+            for (const PendingCommandList& pending : m_PendingCommandLists)
+            {
+                if (pending.CommandList->getDesc().queueType == queue)
+                    m_SubmitScratch.push_back(pending.CommandList);
+            }
+
+            if (m_SubmitScratch.empty())
+                continue;
+
+            uint64_t submission = executeCommandLists(m_SubmitScratch.data(), m_SubmitScratch.size(), queue);
+            m_NvrhiDevice->queueWaitForCommandList(nvrhi::CommandQueue::Graphics, queue, submission);
+        }
+
+        m_SubmitScratch.clear();
+        for (const PendingCommandList& pending : m_PendingCommandLists)
+        {
+            if (pending.CommandList->getDesc().queueType == nvrhi::CommandQueue::Graphics)
+                m_SubmitScratch.push_back(pending.CommandList);
+        }
+
+        // the semaphores still need a submission to ride on when nothing was recorded this frame
+        if (m_SubmitScratch.empty())
+        {
+            m_EndOfFrameCommandList->open();
+            m_EndOfFrameCommandList->close();
+            m_SubmitScratch.push_back(m_EndOfFrameCommandList);
+        }
+
+        executeCommandLists(m_SubmitScratch.data(), m_SubmitScratch.size(), nvrhi::CommandQueue::Graphics);
+        m_PendingCommandLists.clear();
+
+        m_SubmittedGpuValue = signalValue;
+        m_FrameGpuValues[m_FrameIndex] = signalValue;
+
+        m_LastSubmitStats = m_CurrentSubmitStats;
+
+        if (m_Headless)
+        {
+            m_FrameIndex = (m_FrameIndex + 1) % m_FramesInFlight;
+            m_FrameNumber++;
+            SIL_PROFILE_END_FRAME();
+            return;
+        }
 
         VkPresentInfoKHR present{};
 		present.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -385,21 +630,209 @@ namespace silica {
 		present.pSwapchains = &m_Swapchain;
 		present.pImageIndices = &m_SwapchainIndex;
 
-		result = vkQueuePresentKHR(m_PresentQueue, &present);
-		VK_CHECK(result, "failed to present Vulkan queue!");
+		VkResult result = vkQueuePresentKHR(m_PresentQueue, &present);
+		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
+			m_SwapchainDirty = true;
+		else
+			VK_CHECK(result, "failed to present Vulkan queue!");
+
+        m_FrameIndex = (m_FrameIndex + 1) % m_FramesInFlight;
+        m_FrameNumber++;
+        SIL_PROFILE_END_FRAME();
+    }
+
+    void VulkanDevice::submitCommandList(nvrhi::ICommandList* commandList, uint32_t order)
+    {
+        std::lock_guard<std::mutex> lock(m_SubmitMutex);
+        m_PendingCommandLists.push_back({ commandList, order, m_SubmitSequence++ });
+    }
+
+    nvrhi::ICommandList* VulkanDevice::beginCommandList()
+    {
+        ThreadCommandLists::Frame& frame = getThreadCommandLists().Frames[m_FrameIndex];
+
+        if (frame.Used == frame.CommandLists.size())
+        {
+            // immediate execution allows only one open command list at a time
+            nvrhi::CommandListParameters params = nvrhi::CommandListParameters()
+                .setEnableImmediateExecution(false);
+            frame.CommandLists.push_back(m_NvrhiDevice->createCommandList(params));
+        }
+
+        nvrhi::ICommandList* commandList = frame.CommandLists[frame.Used++];
+        commandList->open();
+        return commandList;
+    }
 
-        m_FrameIndex = (m_FrameIndex + 1) % SIL_FRAMES_IN_FLIGHT;
+    void VulkanDevice::endCommandList(nvrhi::ICommandList* commandList, uint32_t order)
+    {
+        commandList->close();
+        submitCommandList(commandList, order);
+    }
+
+    VulkanDevice::ThreadCommandLists& VulkanDevice::getThreadCommandLists()
+    {
+        // the serial guards against a new device reusing a destroyed device's address
+        thread_local uint64_t cachedSerial = 0;
+        thread_local ThreadCommandLists* cachedLists = nullptr;
+
+        if (cachedSerial == m_DeviceSerial)
+            return *cachedLists;
+
+        std::lock_guard<std::mutex> lock(m_ThreadCommandListsMutex);
+
+        std::thread::id threadID = std::this_thread::get_id();
+        auto it = std::find_if(m_ThreadCommandLists.begin(), m_ThreadCommandLists.end(), [threadID](const auto& lists) { return lists->ThreadID == threadID; });
+
+        if (it == m_ThreadCommandLists.end())
+        {
+            auto& lists = m_ThreadCommandLists.emplace_back(std::make_unique<ThreadCommandLists>());
+            lists->ThreadID = threadID;
+            lists->Frames.resize(m_FramesInFlight);
+            it = m_ThreadCommandLists.end() - 1;
+        }
+
+        cachedSerial = m_DeviceSerial;
+        cachedLists = it->get();
+        return *cachedLists;
+    }
+
+    void VulkanDevice::recycleThreadCommandLists(uint32_t frameIndex)
+    {
+        std::lock_guard<std::mutex> lock(m_ThreadCommandListsMutex);
+
+        for (auto& lists : m_ThreadCommandLists)
+            lists->Frames[frameIndex].Used = 0;
+    }
+
+    bool VulkanDevice::hasDedicatedQueue(nvrhi::CommandQueue queue) const
+    {
+        switch (queue)
+        {
+        case nvrhi::CommandQueue::Graphics: return true;
+        case nvrhi::CommandQueue::Compute:  return m_QueueFamilies.hasCompute();
+        case nvrhi::CommandQueue::Copy:     return m_QueueFamilies.hasTransfer();
+        default:
+            return false;
+        }
+    }
+
+    uint64_t VulkanDevice::executeCommandList(nvrhi::ICommandList* commandList)
+    {
+        std::lock_guard<std::mutex> lock(m_SubmitMutex);
+        return executeCommandLists(&commandList, 1, commandList->getDesc().queueType);
+    }
+
+    void VulkanDevice::queueWaitForCommandList(nvrhi::CommandQueue waitQueue, nvrhi::CommandQueue executionQueue, uint64_t submission)
+    {
+        std::lock_guard<std::mutex> lock(m_SubmitMutex);
+        m_NvrhiDevice->queueWaitForCommandList(waitQueue, executionQueue, submission);
+    }
+
+    uint64_t VulkanDevice::executeCommandLists(nvrhi::ICommandList* const* commandLists, size_t count, nvrhi::CommandQueue queue)
+    {
+        uint64_t submission = m_NvrhiDevice->executeCommandLists(commandLists, count, queue);
+
+        m_CurrentSubmitStats.Submissions++;
+        m_CurrentSubmitStats.CommandLists += (uint32_t)count;
+        return submission;
+    }
+
+    void VulkanDevice::waitForGpuValue(uint64_t value)
+    {
+        if (m_CompletedGpuValue.load(std::memory_order_acquire) >= value)
+            return;
+
+        VkSemaphoreWaitInfo waitInfo{};
+        waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        waitInfo.semaphoreCount = 1;
+        waitInfo.pSemaphores = &m_TimelineSemaphore;
+        waitInfo.pValues = &value;
+
+        VkResult result = vkWaitSemaphores(m_Device, &waitInfo, std::numeric_limits<uint64_t>::max());
+        VK_CHECK(result, "failed to wait for Vulkan timeline semaphore!");
+
+        updateCompletedGpuValue();
+    }
+
+    void VulkanDevice::releaseResource(std::shared_ptr<Resource> resource)
+    {
+        if (!resource)
+            return;
+
+        SIL_ASSERT(resource.get() != this, "A device cannot release itself");
+
+        uint64_t lastUsed = resource->getLastUsedGpuValue();
+        m_ReleaseQueue.push(lastUsed != 0 ? lastUsed : getCurrentFrameGpuValue(), std::move(resource));
+    }
+
+    void VulkanDevice::updateCompletedGpuValue()
+    {
+        uint64_t completed = 0;
+        vkGetSemaphoreCounterValue(m_Device, m_TimelineSemaphore, &completed);
+
+        uint64_t previous = m_CompletedGpuValue.load(std::memory_order_relaxed);
+        while (previous < completed && !m_CompletedGpuValue.compare_exchange_weak(previous, completed, std::memory_order_release, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    void VulkanDevice::beginGpuScope(nvrhi::ICommandList* commandList, const char* name)
+    {
+        VkCommandBuffer commandBuffer = commandList->getNativeObject(nvrhi::ObjectTypes::VK_CommandBuffer);
+        m_GpuProfiler.beginScope(commandBuffer, name);
+    }
+
+    void VulkanDevice::endGpuScope(nvrhi::ICommandList* commandList)
+    {
+        VkCommandBuffer commandBuffer = commandList->getNativeObject(nvrhi::ObjectTypes::VK_CommandBuffer);
+        m_GpuProfiler.endScope(commandBuffer);
+    }
+
+    std::vector<GpuFrameTimings> VulkanDevice::getGpuFrameTimings(uint32_t frameCount) const
+    {
+        return m_GpuProfiler.getFrameTimings(frameCount);
+    }
+
+    void VulkanDevice::aliasingBarrier(nvrhi::ICommandList* commandList)
+    {
+        // pending nvrhi barriers go first, and clearState ends the render pass a pipeline barrier can't be recorded in
+        commandList->commitBarriers();
+        commandList->clearState();
+
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+        VkCommandBuffer commandBuffer = commandList->getNativeObject(nvrhi::ObjectTypes::VK_CommandBuffer);
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
     }
 
     void VulkanDevice::destroy()
     {
         if (m_Valid && m_Instance)
         {
+            m_PipelineLibrary.destroy();
+            destroySwapchain();
+            m_EndOfFrameCommandList = nullptr;
+            m_PendingCommandLists.clear();
+            m_UploadManager.destroy();
+            m_MemoryAllocator.destroy();
+            m_BindlessHeap.destroy();
+            m_MemoryBudget.track(MemoryCategory::Buffer, -(int64_t)m_UploadRingBytes);
+            m_ThreadCommandLists.clear();
+
             getNvrhiDevice<nvrhi::DeviceHandle>()->runGarbageCollection();
             m_NvrhiDevice = nullptr;
             resetNvrhiDevice();
 
             vkDeviceWaitIdle(m_Device);
+
+            m_PipelineCache.save();
+            m_PipelineCache.destroy();
+            m_GpuProfiler.destroy();
+            destroySyncObjects();
             
             vkDestroyDevice(m_Device, m_Instance->getAllocator());
         }
@@ -413,35 +846,107 @@ namespace silica {
 
     void VulkanDevice::pickPhysicalDevice()
     {
+        SIL_PROFILE_FUNCTION();
+
         uint32_t deviceCount = 0;
         vkEnumeratePhysicalDevices(m_Instance->getInstance(), &deviceCount, nullptr);
 
         std::vector<VkPhysicalDevice> devices(deviceCount);
         vkEnumeratePhysicalDevices(m_Instance->getInstance(), &deviceCount, devices.data());
 
-        for (const auto& device : devices)
+        m_PhysicalDevices.clear();
+        m_PhysicalDevices.reserve(deviceCount);
+        for (VkPhysicalDevice device : devices)
+            m_PhysicalDevices.push_back(utils::queryPhysicalDeviceCaps(device, m_Instance->getSurface()));
+
+        std::vector<utils::AdapterCandidate> candidates(deviceCount);
+        for (uint32_t i = 0; i < deviceCount; i++)
+        {
+            utils::AdapterCandidate& candidate = candidates[i];
+            candidate.Caps = &m_PhysicalDevices[i];
+            candidate.Index = i;
+
+            if (!utils::isDeviceSuitable(m_PhysicalDevices[i], m_Instance->getSurface() != nullptr, m_DeviceExtensions))
+                continue;
+
+            // only negotiated to see what the device offers, the picked one is negotiated again below
+            std::vector<const char*> extensions = m_DeviceExtensions;
+            candidate.Suitable = true;
+            candidate.Score = utils::scoreDevice(candidate, m_PhysicalDevices[i].Features->negotiate(extensions));
+        }
+
+        std::stable_sort(candidates.begin(), candidates.end(), [](const utils::AdapterCandidate& a, const utils::AdapterCandidate& b)
+        {
+            if (a.Suitable != b.Suitable)
+                return a.Suitable;
+            return a.Score > b.Score;
+        });
+
+        const bool hasOverride = m_Info.AdapterIndex >= 0 || !m_Info.AdapterName.empty() || m_Info.AdapterVendorID != 0 || m_Info.AdapterDeviceID != 0;
+
+        const utils::AdapterCandidate* picked = nullptr;
+        if (hasOverride)
         {
-            if (utils::isDeviceSuitable(device, m_Instance->getSurface()))
+            for (const utils::AdapterCandidate& candidate : candidates)
             {
-                m_PhysicalDevice = device;
-                break;
+                if (candidate.Suitable && utils::matchesAdapterOverride(candidate, m_Info))
+                {
+                    picked = &candidate;
+                    break;
+                }
             }
+
+            if (!picked)
+                SIL_WARN("No suitable GPU matches the adapter override, using the highest scored one");
         }
 
-        SIL_ASSERT(m_PhysicalDevice, "Failed to find a suitable GPU!");
+        if (!picked && !candidates.empty() && candidates.front().Suitable)
+            picked = &candidates.front();
+
+        SIL_INFO("GPUs by score:");
+        for (const utils::AdapterCandidate& candidate : candidates)
+        {
+            const VkPhysicalDeviceProperties& properties = candidate.Caps->Properties;
+            SIL_INFO("  {} [{}] {} ({}, {:04x}:{:04x}, {} MiB): {}", &candidate == picked ? "*" : " ", candidate.Index, properties.deviceName,
+                utils::getDeviceTypeName(properties.deviceType), properties.vendorID, properties.deviceID,
+                candidate.Caps->DeviceLocalBytes / (1024 * 1024), candidate.Suitable ? std::to_string(candidate.Score) : "unsuitable");
+        }
 
-        VkPhysicalDeviceProperties properties;
-        vkGetPhysicalDeviceProperties(m_PhysicalDevice, &properties);
-        
-        SIL_INFO("Using device: {}", properties.deviceName);
+        SIL_ASSERT(picked, "Failed to find a suitable GPU!");
+
+        m_PhysicalDeviceCaps = &m_PhysicalDevices[picked->Index];
+        m_PhysicalDevice = m_PhysicalDeviceCaps->Device;
+        m_QueueFamilies = m_PhysicalDeviceCaps->QueueFamilies;
+        m_Capabilities = m_PhysicalDeviceCaps->Features->negotiate(m_DeviceExtensions);
+
+        if (!m_Capabilities.MemoryBudget)
+            SIL_WARN("VK_EXT_memory_budget is not supported, memory usage is estimated from engine allocations");
+
+        if (m_Info.EnableBindless)
+        {
+            m_BindlessEnabled = m_Capabilities.DescriptorIndexing;
+            if (!m_BindlessEnabled)
+                SIL_WARN("Descriptor indexing is not fully supported, bindless is disabled");
+        }
+
+        SIL_INFO("Using device: {}", m_PhysicalDeviceCaps->Properties.deviceName);
+        SIL_INFO("Device capabilities: synchronization2 {}, buffer device address {}, descriptor indexing {}, dynamic rendering {}, memory budget {}, present wait {}",
+            m_Capabilities.Synchronization2, m_Capabilities.BufferDeviceAddress, m_Capabilities.DescriptorIndexing,
+            m_Capabilities.DynamicRendering, m_Capabilities.MemoryBudget, m_Capabilities.PresentWait);
     }
 
     void VulkanDevice::createLogicalDevice()
     {
-        QueueFamilyIndices indices = utils::findQueueFamilies(m_PhysicalDevice, m_Instance->getSurface());
+        SIL_PROFILE_FUNCTION();
+
+        const QueueFamilyIndices& indices = m_QueueFamilies;
 
         std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
         std::set<uint32_t> uniqueQueueFamilies = { indices.GraphicsFamily, indices.PresentFamily };
+        if (indices.hasCompute())
+            uniqueQueueFamilies.insert(indices.ComputeFamily);
+        if (indices.hasTransfer())
+            uniqueQueueFamilies.insert(indices.TransferFamily);
 
         float queuePriority = 1.0f;
         for (uint32_t queueFamily : uniqueQueueFamilies)
@@ -453,17 +958,14 @@ namespace silica {
             queueCreateInfo.pQueuePriorities = &queuePriority;
         }
 
-        VkPhysicalDeviceFeatures deviceFeatures{};
-        deviceFeatures.sampleRateShading = VK_TRUE;
-        deviceFeatures.samplerAnisotropy = VK_TRUE;
-
         VkDeviceCreateInfo createInfo{};
         createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
         createInfo.queueCreateInfoCount = (uint32_t)queueCreateInfos.size();
         createInfo.pQueueCreateInfos = queueCreateInfos.data();
-        createInfo.pEnabledFeatures = &deviceFeatures;
-        createInfo.enabledExtensionCount = (uint32_t)s_DeviceExtensions.size();
-        createInfo.ppEnabledExtensionNames = s_DeviceExtensions.data();
+        createInfo.pEnabledFeatures = m_PhysicalDeviceCaps->Features->getEnabledCoreFeatures();
+        createInfo.pNext = m_PhysicalDeviceCaps->Features->getEnabledChain();
+        createInfo.enabledExtensionCount = (uint32_t)m_DeviceExtensions.size();
+        createInfo.ppEnabledExtensionNames = m_DeviceExtensions.data();
 
         if (s_EnableValidationLayers)
         {
@@ -475,42 +977,46 @@ namespace silica {
             createInfo.enabledLayerCount = 0;
         }
 
-        VkPhysicalDeviceFloat16Int8FeaturesKHR float16FeaturesEnable{};
-        float16FeaturesEnable.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FLOAT16_INT8_FEATURES_KHR;
-        float16FeaturesEnable.shaderFloat16 = VK_TRUE;
-
-        VkPhysicalDeviceVulkan11Features vulkan11Features{};
-        vulkan11Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES;
-        vulkan11Features.shaderDrawParameters = VK_TRUE;
-
-        VkPhysicalDeviceTimelineSemaphoreFeatures timelineSemaphoreFeatures{};
-		timelineSemaphoreFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
-		timelineSemaphoreFeatures.timelineSemaphore = VK_TRUE;
-
-        vulkan11Features.pNext = &timelineSemaphoreFeatures;
-        float16FeaturesEnable.pNext = &vulkan11Features;
-        createInfo.pNext = &float16FeaturesEnable;
-
         VkResult result = vkCreateDevice(m_PhysicalDevice, &createInfo, m_Instance->getAllocator(), &m_Device);
         VK_CHECK(result, "Failed to create Vulkan device!");
 
         loadExtensions();
 
         VK_DEBUG_NAME(m_Device, DEVICE, m_Device, "VulkanRenderer::m_Device");
-        VK_DEBUG_NAME(m_Device, SURFACE_KHR, m_Instance->getSurface(), "VulkanRenderer::m_Surface");
+        if (!m_Headless)
+            VK_DEBUG_NAME(m_Device, SURFACE_KHR, m_Instance->getSurface(), "VulkanRenderer::m_Surface");
 
         vkGetDeviceQueue(m_Device, indices.GraphicsFamily, 0, &m_GraphicsQueue);
         vkGetDeviceQueue(m_Device, indices.PresentFamily, 0, &m_PresentQueue);
 
         VK_DEBUG_NAME(m_Device, QUEUE, m_GraphicsQueue, "VulkanRenderer::m_GraphicsQueue");
         VK_DEBUG_NAME(m_Device, QUEUE, m_PresentQueue, "VulkanRenderer::m_PresentQueue");
+
+        if (indices.hasCompute())
+        {
+            vkGetDeviceQueue(m_Device, indices.ComputeFamily, 0, &m_ComputeQueue);
+            VK_DEBUG_NAME(m_Device, QUEUE, m_ComputeQueue, "VulkanRenderer::m_ComputeQueue");
+        }
+
+        if (indices.hasTransfer())
+        {
+            vkGetDeviceQueue(m_Device, indices.TransferFamily, 0, &m_TransferQueue);
+            VK_DEBUG_NAME(m_Device, QUEUE, m_TransferQueue, "VulkanRenderer::m_TransferQueue");
+        }
+
+        SIL_DEBUG_LOG("Vulkan queue families: graphics {}, present {}, compute {}, transfer {}",
+            indices.GraphicsFamily, indices.PresentFamily,
+            indices.hasCompute() ? std::to_string(indices.ComputeFamily) : "shared",
+            indices.hasTransfer() ? std::to_string(indices.TransferFamily) : "shared");
     }
 
     void VulkanDevice::createNVRHIDevice()
     {
-        QueueFamilyIndices indices = utils::findQueueFamilies(m_PhysicalDevice, m_Instance->getSurface());
+        SIL_PROFILE_FUNCTION();
+
+        const QueueFamilyIndices& indices = m_QueueFamilies;
 
-        std::vector<const char*> instanceExtensions = utils::getRequiredInstanceExtensions();
+        const std::vector<const char*>& instanceExtensions = m_Instance->getEnabledExtensions();
 
         nvrhi::vulkan::DeviceDesc deviceDesc{};
         deviceDesc.errorCB = &m_MessageCallback;
@@ -519,39 +1025,34 @@ namespace silica {
         deviceDesc.device = m_Device;
         deviceDesc.graphicsQueue = m_GraphicsQueue;
         deviceDesc.graphicsQueueIndex = indices.GraphicsFamily;
+        if (indices.hasCompute())
+        {
+            deviceDesc.computeQueue = m_ComputeQueue;
+            deviceDesc.computeQueueIndex = indices.ComputeFamily;
+        }
+        if (indices.hasTransfer())
+        {
+            deviceDesc.transferQueue = m_TransferQueue;
+            deviceDesc.transferQueueIndex = indices.TransferFamily;
+        }
         deviceDesc.allocationCallbacks = const_cast<VkAllocationCallbacks*>(m_Instance->getAllocator());
         deviceDesc.numInstanceExtensions = instanceExtensions.size();
-        deviceDesc.instanceExtensions = instanceExtensions.data();
-        deviceDesc.numDeviceExtensions = s_DeviceExtensions.size();
-        deviceDesc.deviceExtensions = const_cast<const char**>(s_DeviceExtensions.data());
+        deviceDesc.instanceExtensions = const_cast<const char**>(instanceExtensions.data());
+        deviceDesc.numDeviceExtensions = m_DeviceExtensions.size();
+        deviceDesc.deviceExtensions = const_cast<const char**>(m_DeviceExtensions.data());
+        deviceDesc.bufferDeviceAddressSupported = m_Capabilities.BufferDeviceAddress;
 
         m_NvrhiDevice = nvrhi::vulkan::createDevice(deviceDesc);
         nvrhi::DeviceHandle device = m_NvrhiDevice;
         setNvrhiDevice(&device);
+
+        m_EndOfFrameCommandList = m_NvrhiDevice->createCommandList();
     }
 
     void VulkanDevice::createDispatchLoaderDynamic()
     {
         vk::detail::defaultDispatchLoaderDynamic.init(m_Instance->getInstance(), m_Device);
-    }
-
-    void VulkanDevice::createCommandPool()
-    {
-        VkCommandPoolCreateInfo poolInfo{};
-		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-		poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-
-		VkResult result = vkCreateCommandPool(m_Device, &poolInfo, m_Instance->getAllocator(), &m_CommandPool);
-		VK_CHECK(result, "Failed to create Vulkan command pool!");
-
-		VkCommandBufferAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		allocInfo.commandBufferCount = SIL_FRAMES_IN_FLIGHT;
-		allocInfo.commandPool = m_CommandPool;
-		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		
-		result = vkAllocateCommandBuffers(m_Device, &allocInfo, m_EndOfFrameCommandBuffers.data());
-		VK_CHECK(result, "Failed to allocate Vulkan command buffers!");
+        m_PipelineCache.hookDispatch(vk::detail::defaultDispatchLoaderDynamic);
     }
 
     void VulkanDevice::createSyncObjects()
@@ -559,40 +1060,76 @@ namespace silica {
         VkSemaphoreCreateInfo semaphoreInfo{};
 		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-		VkFenceCreateInfo fenceInfo{};
-		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-		fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+		m_PresentSemaphores.resize(m_FramesInFlight);
+		m_EndOfFrameSemaphores.resize(m_FramesInFlight);
+		m_FrameGpuValues.assign(m_FramesInFlight, 0);
 
-		for (size_t i = 0; i < SIL_FRAMES_IN_FLIGHT; i++)
+		for (uint32_t i = 0; i < m_FramesInFlight; i++)
 		{
 			VkResult result = vkCreateSemaphore(m_Device, &semaphoreInfo, m_Instance->getAllocator(), &m_PresentSemaphores[i]);
 			VK_CHECK(result, "Failed to create Vulkan semaphore!");
 
 			result = vkCreateSemaphore(m_Device, &semaphoreInfo, m_Instance->getAllocator(), &m_EndOfFrameSemaphores[i]);
 			VK_CHECK(result, "Failed to create Vulkan semaphore!");
-
-			result = vkCreateFence(m_Device, &fenceInfo, m_Instance->getAllocator(), &m_InFlightFences[i]);
-			VK_CHECK(result, "Failed to create Vulkan fence!");
 		}
+
+		VkSemaphoreTypeCreateInfo timelineInfo{};
+		timelineInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+		timelineInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+		timelineInfo.initialValue = 0;
+
+		semaphoreInfo.pNext = &timelineInfo;
+
+		VkResult result = vkCreateSemaphore(m_Device, &semaphoreInfo, m_Instance->getAllocator(), &m_TimelineSemaphore);
+		VK_CHECK(result, "Failed to create Vulkan timeline semaphore!");
+    }
+
+    void VulkanDevice::destroySyncObjects()
+    {
+        for (uint32_t i = 0; i < m_FramesInFlight; i++)
+        {
+            vkDestroySemaphore(m_Device, m_PresentSemaphores[i], m_Instance->getAllocator());
+            vkDestroySemaphore(m_Device, m_EndOfFrameSemaphores[i], m_Instance->getAllocator());
+        }
+
+        vkDestroySemaphore(m_Device, m_TimelineSemaphore, m_Instance->getAllocator());
+
+        m_PresentSemaphores.clear();
+        m_EndOfFrameSemaphores.clear();
+        m_TimelineSemaphore = nullptr;
     }
 
-    void VulkanDevice::createSwapchain()
+    bool VulkanDevice::createSwapchain()
     {
+        SIL_PROFILE_FUNCTION();
+
+        int width, height;
+        glfwGetFramebufferSize(m_Instance->getWindow(), &width, &height);
+        m_WindowExtent = { (uint32_t)width, (uint32_t)height };
+
         VkSwapchainKHR oldSwapchain = m_Swapchain;
-		m_SwapchainImages.clear();
 
-		SwapchainSupportDetails swapchainSupport = utils::querySwapchainSupport(m_PhysicalDevice, m_Instance->getSurface());
+		// formats and present modes are fixed for the surface, but its extent and transform follow the window
+		SwapchainSupportDetails& swapchainSupport = m_PhysicalDeviceCaps->SwapchainSupport;
+		vkGetPhysicalDeviceSurfaceCapabilitiesKHR(m_PhysicalDevice, m_Instance->getSurface(), &swapchainSupport.Capabilities);
 		VkSurfaceFormatKHR surfaceFormat = utils::chooseSwapSurfaceFormat(swapchainSupport.Formats);
-		VkPresentModeKHR presentMode = utils::chooseSwapPresentMode(swapchainSupport.PresentModes);
+		VkPresentModeKHR presentMode = utils::chooseSwapPresentMode(swapchainSupport.PresentModes, m_Info.PreferredPresentMode);
 		VkExtent2D extent = utils::chooseSwapExtent(m_Instance->getWindow(), swapchainSupport.Capabilities);
 
+		if (extent.width == 0 || extent.height == 0)
+			return false;
+
 		m_SwapchainImageFormat = utils::convertFormat(surfaceFormat.format);
 
-		uint32_t imageCount = swapchainSupport.Capabilities.minImageCount + 1;
+		uint32_t imageCount = m_Info.SwapchainImageCount ? m_Info.SwapchainImageCount : swapchainSupport.Capabilities.minImageCount + 1;
+		imageCount = std::max(imageCount, swapchainSupport.Capabilities.minImageCount);
 
 		if (swapchainSupport.Capabilities.maxImageCount > 0 && imageCount > swapchainSupport.Capabilities.maxImageCount)
 			imageCount = swapchainSupport.Capabilities.maxImageCount;
 
+		if (presentMode != utils::convertPresentMode(m_Info.PreferredPresentMode) && !oldSwapchain)
+			SIL_WARN("Requested present mode is not supported, falling back to {}", presentMode == VK_PRESENT_MODE_MAILBOX_KHR ? "MAILBOX" : "FIFO");
+
 		m_SwapchainImageCount = imageCount;
 
 		VkSwapchainCreateInfoKHR createInfo{};
@@ -606,7 +1143,7 @@ namespace silica {
 		createInfo.oldSwapchain = oldSwapchain;
 		createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
 
-		QueueFamilyIndices indices = utils::findQueueFamilies(m_PhysicalDevice, m_Instance->getSurface());
+		const QueueFamilyIndices& indices = m_QueueFamilies;
 		uint32_t queueFamilyIndices[] = { indices.GraphicsFamily, indices.PresentFamily };
 
 		if (indices.GraphicsFamily != indices.PresentFamily)
@@ -628,6 +1165,20 @@ namespace silica {
 		VkResult result = vkCreateSwapchainKHR(m_Device, &createInfo, m_Instance->getAllocator(), &m_Swapchain);
 		VK_CHECK(result, "Failed to create Vulkan swapchain");
 
+		m_ImageFormat = createInfo.imageFormat;
+		m_Extent = extent;
+
+		// frames still in flight can reference the old images, so they are released once those frames retire
+		if (oldSwapchain)
+		{
+			m_ReleaseQueue.push(m_SubmittedGpuValue, [this, swapchain = oldSwapchain, images = std::move(m_SwapchainImages)]() mutable
+			{
+				images.clear();
+				vkDestroySwapchainKHR(m_Device, swapchain, m_Instance->getAllocator());
+			});
+		}
+		m_SwapchainImages.clear();
+
 		vkGetSwapchainImagesKHR(m_Device, m_Swapchain, &m_SwapchainImageCount, nullptr);
 		std::vector<VkImage> images(m_SwapchainImageCount);
 		vkGetSwapchainImagesKHR(m_Device, m_Swapchain, &m_SwapchainImageCount, images.data());
@@ -654,11 +1205,56 @@ namespace silica {
 		}
 
 		m_SwapchainIndex = 0;
+		return true;
+    }
 
-		if (oldSwapchain)
-		{
-			vkDestroySwapchainKHR(m_Device, oldSwapchain, m_Instance->getAllocator());
-		}
+    bool VulkanDevice::recreateSwapchain()
+    {
+        if (!createSwapchain())
+            return false;
+
+        m_SwapchainDirty = false;
+        SIL_DEBUG_LOG("Recreated Vulkan swapchain ({}x{}, {} images)", m_Extent.width, m_Extent.height, m_SwapchainImageCount);
+        return true;
+    }
+
+    void VulkanDevice::createOffscreenTargets()
+    {
+        SIL_PROFILE_FUNCTION();
+
+        m_SwapchainImages.clear();
+
+        m_Extent = { m_Info.HeadlessWidth, m_Info.HeadlessHeight };
+        m_ImageFormat = VK_FORMAT_B8G8R8A8_UNORM;
+        m_SwapchainImageFormat = utils::convertFormat(m_ImageFormat);
+        m_SwapchainImageCount = std::max(m_Info.HeadlessImageCount, m_FramesInFlight);
+
+        for (uint32_t i = 0; i < m_SwapchainImageCount; i++)
+        {
+            nvrhi::TextureDesc textureDesc = nvrhi::TextureDesc()
+                .setWidth(m_Extent.width)
+                .setHeight(m_Extent.height)
+                .setSampleCount(1)
+                .setSampleQuality(0)
+                .setFormat(m_SwapchainImageFormat)
+                .setDebugName("Offscreen Buffer")
+                .setIsRenderTarget(true)
+                .setIsUAV(false)
+                .setInitialState(nvrhi::ResourceStates::RenderTarget)
+                .setKeepInitialState(true);
+
+            SwapchainImage offscreenImage;
+            offscreenImage.NVRHIHandle = getNvrhiDevice<nvrhi::DeviceHandle>()->createTexture(textureDesc);
+            offscreenImage.Image = offscreenImage.NVRHIHandle->getNativeObject(nvrhi::ObjectTypes::VK_Image);
+            m_SwapchainImages.push_back(offscreenImage);
+
+            m_OffscreenTargetBytes += getNvrhiDevice<nvrhi::DeviceHandle>()->getTextureMemoryRequirements(offscreenImage.NVRHIHandle).size;
+        }
+
+        m_MemoryBudget.track(MemoryCategory::RenderTarget, (int64_t)m_OffscreenTargetBytes);
+
+        // beginFrame advances before rendering, so the first frame lands on image 0
+        m_SwapchainIndex = m_SwapchainImageCount - 1;
     }
 
     void VulkanDevice::destroySwapchain()
@@ -667,6 +1263,9 @@ namespace silica {
 		{
 			vkDeviceWaitIdle(m_Device);
 		}
+		// retired swapchains and everything else released while frames were in flight
+		m_ReleaseQueue.flush();
+
 		if (m_Swapchain)
 		{
 			vkDestroySwapchainKHR(m_Device, m_Swapchain, m_Instance->getAllocator());
@@ -674,6 +1273,9 @@ namespace silica {
 		}
 
 		m_SwapchainImages.clear();
+
+        m_MemoryBudget.track(MemoryCategory::RenderTarget, -(int64_t)m_OffscreenTargetBytes);
+        m_OffscreenTargetBytes = 0;
     }
 
     void VulkanDevice::loadExtensions()
@@ -1,14 +1,26 @@
 #pragma once
 
 #include "VulkanInstance.h"
+#include "VulkanGpuProfiler.h"
+#include "VulkanUploadManager.h"
+#include "VulkanPipelineCache.h"
+#include "VulkanMemoryBudget.h"
+#include "VulkanMemoryAllocator.h"
+#include "VulkanReleaseQueue.h"
+#include "VulkanFeatures.h"
 #include "Renderer/Device.h"
+#include "Renderer/PipelineLibrary.h"
+#include "Renderer/BindlessHeap.h"
 
 #include <nvrhi/nvrhi.h>
 #include <nvrhi/vulkan.h>
 #include <vulkan/vulkan.h>
 
-#include <array>
 #include <vector>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <memory>
 
 namespace silica {
 
@@ -16,8 +28,13 @@ namespace silica {
     {
         uint32_t GraphicsFamily = static_cast<uint32_t>(-1);
         uint32_t PresentFamily = static_cast<uint32_t>(-1);
+        // families without graphics (and for transfer, without compute) so their queues run alongside graphics
+        uint32_t ComputeFamily = static_cast<uint32_t>(-1);
+        uint32_t TransferFamily = static_cast<uint32_t>(-1);
 
         bool isComplete() const { return GraphicsFamily != static_cast<uint32_t>(-1) && PresentFamily != static_cast<uint32_t>(-1); }
+        bool hasCompute() const { return ComputeFamily != static_cast<uint32_t>(-1); }
+        bool hasTransfer() const { return TransferFamily != static_cast<uint32_t>(-1); }
     };
 
     struct SwapchainSupportDetails
@@ -27,14 +44,88 @@ namespace silica {
         std::vector<VkPresentModeKHR> PresentModes;
     };
 
+    // everything device selection and bring-up ask about a physical device, queried once per enumerated device
+    struct PhysicalDeviceCaps
+    {
+        VkPhysicalDevice Device = nullptr;
+        VkPhysicalDeviceProperties Properties{};
+        VkPhysicalDeviceMemoryProperties MemoryProperties{};
+        uint64_t DeviceLocalBytes = 0;
+        std::vector<VkQueueFamilyProperties> QueueFamilyProperties;
+        QueueFamilyIndices QueueFamilies;
+        // empty without a surface; Capabilities is refreshed whenever the swapchain is (re)created
+        SwapchainSupportDetails SwapchainSupport;
+        std::unique_ptr<VulkanFeatures> Features;
+    };
+
     class VulkanDevice : public Device
     {
     public:
         VulkanDevice(VulkanInstance* instance, const DeviceInfo& deviceInfo);
         virtual ~VulkanDevice();
 
-        virtual void beginFrame() override;
+        virtual bool beginFrame() override;
         virtual void endFrame() override;
+
+        virtual nvrhi::ITexture* getCurrentBackBuffer() override { return m_SwapchainImages[m_SwapchainIndex].NVRHIHandle; }
+        virtual uint32_t getBackBufferIndex() const override { return m_SwapchainIndex; }
+        virtual uint32_t getBackBufferCount() const override { return (uint32_t)m_SwapchainImages.size(); }
+        virtual uint32_t getFramesInFlight() const override { return m_FramesInFlight; }
+
+        virtual void submitCommandList(nvrhi::ICommandList* commandList, uint32_t order = 0) override;
+        virtual nvrhi::ICommandList* beginCommandList() override;
+        virtual void endCommandList(nvrhi::ICommandList* commandList, uint32_t order = 0) override;
+
+        virtual bool hasDedicatedQueue(nvrhi::CommandQueue queue) const override;
+        virtual uint64_t executeCommandList(nvrhi::ICommandList* commandList) override;
+        virtual void queueWaitForCommandList(nvrhi::CommandQueue waitQueue, nvrhi::CommandQueue executionQueue, uint64_t submission) override;
+
+        virtual void uploadBuffer(nvrhi::IBuffer* buffer, const void* data, size_t size, uint64_t destOffset = 0) override { m_UploadManager.uploadBuffer(buffer, data, size, destOffset); }
+        virtual void uploadTexture(nvrhi::ITexture* texture, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch = 0) override { m_UploadManager.uploadTexture(texture, arraySlice, mipLevel, data, rowPitch, depthPitch); }
+        virtual UploadStats getLastFrameUploadStats() const override { return m_UploadManager.getLastFrameStats(); }
+        virtual FrameSubmitStats getLastFrameSubmitStats() const override { return m_LastSubmitStats; }
+
+        virtual uint64_t getCompletedGpuValue() const override { return m_CompletedGpuValue.load(std::memory_order_acquire); }
+        virtual uint64_t getCurrentFrameGpuValue() const override { return m_SubmittedGpuValue + 1; }
+        virtual void waitForGpuValue(uint64_t value) override;
+
+        virtual void releaseResource(std::shared_ptr<Resource> resource) override;
+        virtual void deferRelease(std::function<void()> release) override { m_ReleaseQueue.push(getCurrentFrameGpuValue(), std::move(release)); }
+
+        virtual nvrhi::IGraphicsPipeline* getGraphicsPipeline(const nvrhi::GraphicsPipelineDesc& desc, nvrhi::IFramebuffer* framebuffer) override { return m_PipelineLibrary.getGraphicsPipeline(desc, framebuffer); }
+        virtual nvrhi::IComputePipeline* getComputePipeline(const nvrhi::ComputePipelineDesc& desc) override { return m_PipelineLibrary.getComputePipeline(desc); }
+        virtual void waitForPipelines() override { m_PipelineLibrary.waitForPending(); }
+        virtual PipelineLibraryStats getPipelineLibraryStats() const override { return m_PipelineLibrary.getStats(); }
+        virtual const DeviceStartupStats& getStartupStats() const override { return m_StartupStats; }
+        PipelineLibrary& getPipelineLibrary() { return m_PipelineLibrary; }
+
+        virtual nvrhi::IBuffer* createPlacedBuffer(const nvrhi::BufferDesc& desc, MemoryStrategy strategy = MemoryStrategy::General) override { return m_MemoryAllocator.createBuffer(desc, strategy); }
+        virtual nvrhi::ITexture* createPlacedTexture(const nvrhi::TextureDesc& desc, MemoryStrategy strategy = MemoryStrategy::General) override { return m_MemoryAllocator.createTexture(desc, strategy); }
+        virtual void releasePlacedResource(nvrhi::IResource* resource) override { m_MemoryAllocator.release(resource, getCurrentFrameGpuValue()); }
+        virtual MemoryAllocatorStats getMemoryAllocatorStats() const override { return m_MemoryAllocator.getStats(); }
+
+        virtual const DeviceCapabilities& getCapabilities() const override { return m_Capabilities; }
+
+        virtual bool isBindlessEnabled() const override { return m_BindlessEnabled; }
+        virtual uint32_t registerBindlessTexture(nvrhi::ITexture* texture, bool storage = false) override { return m_BindlessEnabled ? m_BindlessHeap.registerTexture(texture, storage) : BindlessIndex::Invalid; }
+        virtual uint32_t registerBindlessBuffer(nvrhi::IBuffer* buffer, bool storage = false) override { return m_BindlessEnabled ? m_BindlessHeap.registerBuffer(buffer, storage) : BindlessIndex::Invalid; }
+        virtual void releaseBindless(uint32_t index) override { m_BindlessHeap.release(index, getCurrentFrameGpuValue()); }
+        virtual nvrhi::IBindingLayout* getBindlessLayout() const override { return m_BindlessHeap.getLayout(); }
+        virtual nvrhi::IDescriptorTable* getBindlessTable() const override { return m_BindlessHeap.getDescriptorTable(); }
+        virtual BindlessStats getBindlessStats() const override { return m_BindlessHeap.getStats(); }
+
+        virtual MemoryBudget getMemoryBudget() const override { return m_MemoryBudget.getBudget(); }
+        virtual void trackMemory(MemoryCategory category, int64_t bytes) override { m_MemoryBudget.track(category, bytes); }
+        virtual void setMemoryBudgetCallback(MemoryBudgetCallback callback) override { m_MemoryBudget.setCallback(std::move(callback)); }
+
+        virtual void beginGpuScope(nvrhi::ICommandList* commandList, const char* name) override;
+        virtual void endGpuScope(nvrhi::ICommandList* commandList) override;
+        virtual std::vector<GpuFrameTimings> getGpuFrameTimings(uint32_t frameCount) const override;
+        virtual void aliasingBarrier(nvrhi::ICommandList* commandList) override;
+
+        // nvrhi creates its pipelines without a cache, so this only serves pipelines created through Vulkan directly
+        VkPipelineCache getPipelineCache() const { return m_PipelineCache.getHandle(); }
+        PipelineCacheStats getPipelineCacheStats() const { return m_PipelineCache.getStats(); }
     protected:
         virtual void destroy() override;
         virtual void invalidate() noexcept override;
@@ -43,27 +134,64 @@ namespace silica {
         void createLogicalDevice();
         void createDispatchLoaderDynamic();
         void createNVRHIDevice();
-        void createCommandPool();
         void createSyncObjects();
-        void createSwapchain();
+        void destroySyncObjects();
+        void updateCompletedGpuValue();
+        struct ThreadCommandLists;
+        ThreadCommandLists& getThreadCommandLists();
+        void recycleThreadCommandLists(uint32_t frameIndex);
+
+        uint64_t executeCommandLists(nvrhi::ICommandList* const* commandLists, size_t count, nvrhi::CommandQueue queue);
+        bool createSwapchain();
+        bool recreateSwapchain();
+        void createOffscreenTargets();
         void destroySwapchain();
 
         void loadExtensions();
     private:
         VulkanInstance* m_Instance = nullptr;
+        DeviceInfo m_Info;
+        bool m_Headless = false;
+
+        std::vector<const char*> m_DeviceExtensions;
 
         VkPhysicalDevice m_PhysicalDevice = nullptr;
+        std::vector<PhysicalDeviceCaps> m_PhysicalDevices;
+        PhysicalDeviceCaps* m_PhysicalDeviceCaps = nullptr;
+        DeviceCapabilities m_Capabilities;
+        DeviceStartupStats m_StartupStats;
         VkDevice m_Device = nullptr;
         VkQueue m_GraphicsQueue = nullptr;
         VkQueue m_PresentQueue = nullptr;
-        VkCommandPool m_CommandPool = nullptr;
-        std::array<VkCommandBuffer, SIL_FRAMES_IN_FLIGHT> m_EndOfFrameCommandBuffers;
+        VkQueue m_ComputeQueue = nullptr;
+        VkQueue m_TransferQueue = nullptr;
+        QueueFamilyIndices m_QueueFamilies;
 
-        std::array<VkSemaphore, SIL_FRAMES_IN_FLIGHT> m_EndOfFrameSemaphores;
-		std::array<VkSemaphore, SIL_FRAMES_IN_FLIGHT> m_PresentSemaphores;
-		std::array<VkFence, SIL_FRAMES_IN_FLIGHT> m_InFlightFences;
+        std::vector<VkSemaphore> m_EndOfFrameSemaphores;
+		std::vector<VkSemaphore> m_PresentSemaphores;
 
+        VkSemaphore m_TimelineSemaphore = nullptr;
+        uint64_t m_SubmittedGpuValue = 0;
+        std::atomic<uint64_t> m_CompletedGpuValue = 0;
+        std::vector<uint64_t> m_FrameGpuValues;
+
+        uint32_t m_FramesInFlight = 2;
         uint32_t m_FrameIndex = 0;
+        uint64_t m_FrameNumber = 0;
+
+        VulkanGpuProfiler m_GpuProfiler;
+        VulkanUploadManager m_UploadManager;
+        VulkanPipelineCache m_PipelineCache;
+        PipelineLibrary m_PipelineLibrary;
+        VulkanMemoryBudget m_MemoryBudget;
+        VulkanMemoryAllocator m_MemoryAllocator;
+        VulkanReleaseQueue m_ReleaseQueue;
+        BindlessHeap m_BindlessHeap;
+        // requested through DeviceInfo and supported by the GPU
+        bool m_BindlessEnabled = false;
+        // engine allocations charged to the memory budget at creation, given back at teardown
+        uint64_t m_OffscreenTargetBytes = 0;
+        uint64_t m_UploadRingBytes = 0;
 
         VkSwapchainKHR m_Swapchain = nullptr;
 		VkFormat m_ImageFormat;
@@ -78,11 +206,44 @@ namespace silica {
 		std::vector<SwapchainImage> m_SwapchainImages;
 		nvrhi::Format m_SwapchainImageFormat;
 
+        VkExtent2D m_WindowExtent = { 0, 0 };
+        bool m_SwapchainDirty = false;
+
         uint32_t m_SwapchainIndex = 0;
         uint32_t m_SwapchainImageCount;
 
         nvrhi::vulkan::DeviceHandle m_NvrhiDevice;
         nvrhi::CommandListHandle m_EndOfFrameCommandList;
+        struct PendingCommandList
+        {
+            nvrhi::CommandListHandle CommandList;
+            uint32_t Order;
+            uint64_t Sequence;
+        };
+
+        std::mutex m_SubmitMutex;
+        std::vector<PendingCommandList> m_PendingCommandLists;
+        uint64_t m_SubmitSequence = 0;
+        std::vector<nvrhi::ICommandList*> m_SubmitScratch;
+
+        struct ThreadCommandLists
+        {
+            struct Frame
+            {
+                std::vector<nvrhi::CommandListHandle> CommandLists;
+                size_t Used = 0;
+            };
+
+            std::thread::id ThreadID;
+            std::vector<Frame> Frames;
+        };
+
+        std::mutex m_ThreadCommandListsMutex;
+        std::vector<std::unique_ptr<ThreadCommandLists>> m_ThreadCommandLists;
+        uint64_t m_DeviceSerial = 0;
+
+        FrameSubmitStats m_CurrentSubmitStats;
+        FrameSubmitStats m_LastSubmitStats;
 
         class MessageCallback : public nvrhi::IMessageCallback
         {
@@ -94,7 +255,7 @@ namespace silica {
             {
                 switch (severity)
                 {
-                case nvrhi::MessageSeverity::Info: SIL_INFO("[nvrhi] {}", messageText); break;
+                case nvrhi::MessageSeverity::Info: SIL_DEBUG_LOG("[nvrhi] {}", messageText); break;
                 case nvrhi::MessageSeverity::Warning: SIL_WARN("[nvrhi] {}", messageText); break;
                 case nvrhi::MessageSeverity::Error: SIL_ERROR("[nvrhi] {}", messageText); break;
                 case nvrhi::MessageSeverity::Fatal: SIL_ASSERT_OR_ERROR(false, "[nvrhi] {}", messageText); break;
@@ -109,9 +270,10 @@ namespace silica {
 
     namespace utils {
 
-        QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device, VkSurfaceKHR surface);
+        QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device, VkSurfaceKHR surface, const std::vector<VkQueueFamilyProperties>& queueFamilies);
+        PhysicalDeviceCaps queryPhysicalDeviceCaps(VkPhysicalDevice device, VkSurfaceKHR surface);
         SwapchainSupportDetails querySwapchainSupport(VkPhysicalDevice device, VkSurfaceKHR surface);
-        VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes);
+        VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes, PresentMode preferred);
         VkExtent2D chooseSwapExtent(GLFWwindow* window, const VkSurfaceCapabilitiesKHR& capabilities);
         VkFormat findDepthFormat(VkPhysicalDevice device);
         uint32_t findMemoryType(VkPhysicalDevice physicalDevice, uint32_t typeFilter, VkMemoryPropertyFlags properties);
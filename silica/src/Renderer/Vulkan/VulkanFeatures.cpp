@@ -0,0 +1,190 @@
+#include "VulkanFeatures.h"
+
+#include "Core/Log.h"
+#include "Core/Profiler.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace silica {
+
+    namespace utils {
+
+        static bool containsExtension(const std::vector<const char*>& extensions, const char* name)
+        {
+            return std::any_of(extensions.begin(), extensions.end(), [name](const char* extension) { return std::strcmp(extension, name) == 0; });
+        }
+
+    }
+
+    void VulkanFeatures::query(VkPhysicalDevice device)
+    {
+        SIL_PROFILE_FUNCTION();
+
+        m_PhysicalDevice = device;
+
+        uint32_t extensionCount = 0;
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+        std::vector<VkExtensionProperties> extensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, extensions.data());
+
+        m_Extensions.clear();
+        for (const VkExtensionProperties& extension : extensions)
+            m_Extensions.insert(extension.extensionName);
+
+        m_Supported = {};
+        VkPhysicalDeviceFeatures2 features{};
+        features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features.pNext = link(m_Supported, nullptr);
+        vkGetPhysicalDeviceFeatures2(device, &features);
+
+        m_Supported.Core = features.features;
+    }
+
+    bool VulkanFeatures::hasRequiredFeatures() const
+    {
+        return m_Supported.TimelineSemaphore.timelineSemaphore && m_Supported.HostQueryReset.hostQueryReset;
+    }
+
+    DeviceCapabilities VulkanFeatures::negotiate(std::vector<const char*>& extensions)
+    {
+        const FeatureChain& supported = m_Supported;
+        FeatureChain& enabled = m_Enabled;
+        enabled = {};
+
+        DeviceCapabilities capabilities;
+
+        enabled.Core.sampleRateShading = supported.Core.sampleRateShading;
+        enabled.Core.samplerAnisotropy = supported.Core.samplerAnisotropy;
+        capabilities.SampleRateShading = enabled.Core.sampleRateShading;
+        capabilities.SamplerAnisotropy = enabled.Core.samplerAnisotropy;
+
+        enabled.Float16Int8.shaderFloat16 = supported.Float16Int8.shaderFloat16;
+        enabled.Vulkan11.shaderDrawParameters = supported.Vulkan11.shaderDrawParameters;
+        enabled.TimelineSemaphore.timelineSemaphore = VK_TRUE;
+        enabled.HostQueryReset.hostQueryReset = VK_TRUE;
+        capabilities.ShaderFloat16 = enabled.Float16Int8.shaderFloat16;
+
+        // only ever enabled as the complete set the bindless table needs
+        if (supportsBindless())
+        {
+            VkPhysicalDeviceDescriptorIndexingFeatures& indexing = enabled.DescriptorIndexing;
+            indexing.runtimeDescriptorArray = VK_TRUE;
+            indexing.descriptorBindingPartiallyBound = VK_TRUE;
+            indexing.descriptorBindingVariableDescriptorCount = VK_TRUE;
+            indexing.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+            indexing.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+            indexing.descriptorBindingStorageImageUpdateAfterBind = VK_TRUE;
+            indexing.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+            indexing.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+            indexing.shaderStorageImageArrayNonUniformIndexing = VK_TRUE;
+            indexing.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+            capabilities.DescriptorIndexing = true;
+        }
+
+        if (supported.BufferDeviceAddress.bufferDeviceAddress)
+        {
+            enabled.BufferDeviceAddress.bufferDeviceAddress = VK_TRUE;
+            capabilities.BufferDeviceAddress = true;
+        }
+
+        // core in 1.3 only, so nvrhi finds out about these through the extension list
+        if (supported.Synchronization2.synchronization2)
+        {
+            enabled.Synchronization2.synchronization2 = VK_TRUE;
+            extensions.push_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+            capabilities.Synchronization2 = true;
+        }
+
+        if (supported.DynamicRendering.dynamicRendering)
+        {
+            enabled.DynamicRendering.dynamicRendering = VK_TRUE;
+            extensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+            capabilities.DynamicRendering = true;
+        }
+
+        if (hasExtension(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME))
+        {
+            extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+            capabilities.MemoryBudget = true;
+        }
+
+        // present wait identifies presents by their present ID, so it needs both, and both depend on the
+        // swapchain extension being enabled, which headless devices leave out
+        if (supported.PresentId.presentId && supported.PresentWait.presentWait && utils::containsExtension(extensions, VK_KHR_SWAPCHAIN_EXTENSION_NAME))
+        {
+            enabled.PresentId.presentId = VK_TRUE;
+            enabled.PresentWait.presentWait = VK_TRUE;
+            extensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+            extensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+            capabilities.PresentWait = true;
+        }
+
+        m_EnabledChain = link(enabled, &extensions);
+        return capabilities;
+    }
+
+    void* VulkanFeatures::link(FeatureChain& chain, const std::vector<const char*>* extensions)
+    {
+        chain.Float16Int8.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FLOAT16_INT8_FEATURES_KHR;
+        chain.Vulkan11.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES;
+        chain.TimelineSemaphore.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+        chain.HostQueryReset.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_QUERY_RESET_FEATURES;
+        chain.DescriptorIndexing.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+        chain.BufferDeviceAddress.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES;
+        chain.Synchronization2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+        chain.DynamicRendering.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+        chain.PresentId.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+        chain.PresentWait.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+
+        void* head = nullptr;
+        auto append = [&head](auto& features)
+        {
+            features.pNext = head;
+            head = &features;
+        };
+
+        append(chain.Float16Int8);
+        append(chain.Vulkan11);
+        append(chain.TimelineSemaphore);
+        append(chain.HostQueryReset);
+        append(chain.DescriptorIndexing);
+        append(chain.BufferDeviceAddress);
+
+        // extension structs may only be queried when the device knows the extension, and only passed
+        // to vkCreateDevice when the extension is enabled
+        auto available = [this, extensions](const char* name)
+        {
+            return extensions ? utils::containsExtension(*extensions, name) : hasExtension(name);
+        };
+
+        if (available(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME))
+            append(chain.Synchronization2);
+        if (available(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME))
+            append(chain.DynamicRendering);
+        if (available(VK_KHR_PRESENT_ID_EXTENSION_NAME) && available(VK_KHR_PRESENT_WAIT_EXTENSION_NAME))
+        {
+            append(chain.PresentId);
+            append(chain.PresentWait);
+        }
+
+        return head;
+    }
+
+    bool VulkanFeatures::supportsBindless() const
+    {
+        const VkPhysicalDeviceDescriptorIndexingFeatures& indexing = m_Supported.DescriptorIndexing;
+        return indexing.runtimeDescriptorArray
+            && indexing.descriptorBindingPartiallyBound
+            && indexing.descriptorBindingVariableDescriptorCount
+            && indexing.descriptorBindingUpdateUnusedWhilePending
+            && indexing.descriptorBindingSampledImageUpdateAfterBind
+            && indexing.descriptorBindingStorageImageUpdateAfterBind
+            && indexing.descriptorBindingStorageBufferUpdateAfterBind
+            && indexing.shaderSampledImageArrayNonUniformIndexing
+            && indexing.shaderStorageImageArrayNonUniformIndexing
+            && indexing.shaderStorageBufferArrayNonUniformIndexing;
+    }
+
+}
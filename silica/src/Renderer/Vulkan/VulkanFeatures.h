@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Renderer/Device.h"
+
+#include <vulkan/vulkan.h>
+
+#include <set>
+#include <string>
+#include <vector>
+
+namespace silica {
+
+    // Features and extensions of one physical device, queried once through vkGetPhysicalDeviceFeatures2.
+    // negotiate() enables every optional feature the device has and builds the pNext chain for
+    // VkDeviceCreateInfo from it; the chain points into this object, so it has to outlive device creation.
+    class VulkanFeatures
+    {
+    public:
+        VulkanFeatures() = default;
+        ~VulkanFeatures() = default;
+
+        VulkanFeatures(const VulkanFeatures&) = delete;
+        VulkanFeatures& operator=(const VulkanFeatures&) = delete;
+
+        void query(VkPhysicalDevice device);
+
+        bool hasExtension(const char* name) const { return m_Extensions.count(name) != 0; }
+        // timeline semaphores and host query reset; the frame loop and GPU profiler are built on them
+        bool hasRequiredFeatures() const;
+
+        // extensions holds the ones already enabled; those of the negotiated features are appended
+        DeviceCapabilities negotiate(std::vector<const char*>& extensions);
+
+        const VkPhysicalDeviceFeatures* getEnabledCoreFeatures() const { return &m_Enabled.Core; }
+        void* getEnabledChain() { return m_EnabledChain; }
+    private:
+        struct FeatureChain
+        {
+            VkPhysicalDeviceFeatures Core{};
+            VkPhysicalDeviceFloat16Int8FeaturesKHR Float16Int8{};
+            VkPhysicalDeviceVulkan11Features Vulkan11{};
+            VkPhysicalDeviceTimelineSemaphoreFeatures TimelineSemaphore{};
+            VkPhysicalDeviceHostQueryResetFeatures HostQueryReset{};
+            VkPhysicalDeviceDescriptorIndexingFeatures DescriptorIndexing{};
+            VkPhysicalDeviceBufferDeviceAddressFeatures BufferDeviceAddress{};
+            VkPhysicalDeviceSynchronization2FeaturesKHR Synchronization2{};
+            VkPhysicalDeviceDynamicRenderingFeaturesKHR DynamicRendering{};
+            VkPhysicalDevicePresentIdFeaturesKHR PresentId{};
+            VkPhysicalDevicePresentWaitFeaturesKHR PresentWait{};
+        };
+
+        // chains the core 1.2 structs and every extension struct whose extension is in the list, or that the
+        // device supports when there is no list (for querying), and returns the head
+        void* link(FeatureChain& chain, const std::vector<const char*>* extensions);
+        bool supportsBindless() const;
+    private:
+        VkPhysicalDevice m_PhysicalDevice = nullptr;
+        std::set<std::string> m_Extensions;
+
+        FeatureChain m_Supported;
+        FeatureChain m_Enabled;
+        void* m_EnabledChain = nullptr;
+    };
+
+}
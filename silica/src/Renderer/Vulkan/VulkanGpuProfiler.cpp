@@ -0,0 +1,177 @@
+#include "VulkanGpuProfiler.h"
+
+#include "VulkanInstance.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace silica {
+
+    void VulkanGpuProfiler::create(VkDevice device, const VkPhysicalDeviceProperties& properties, const VkQueueFamilyProperties& queueFamily, const VkAllocationCallbacks* allocator, uint32_t framesInFlight)
+    {
+        m_Device = device;
+        m_Allocator = allocator;
+
+        uint32_t validBits = queueFamily.timestampValidBits;
+
+        m_Supported = validBits != 0 && properties.limits.timestampPeriod > 0.0f;
+        if (!m_Supported)
+        {
+            SIL_WARN("GPU timestamps are not supported on the graphics queue, GPU profiling is disabled");
+            return;
+        }
+
+        m_TimestampPeriod = properties.limits.timestampPeriod;
+        m_TimestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+        VkQueryPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        poolInfo.queryCount = s_MaxScopesPerFrame * 2;
+
+        m_Frames.resize(framesInFlight);
+        for (auto& frame : m_Frames)
+        {
+            VkResult result = vkCreateQueryPool(m_Device, &poolInfo, m_Allocator, &frame.Pool);
+            VK_CHECK(result, "Failed to create Vulkan timestamp query pool!");
+
+            vkResetQueryPool(m_Device, frame.Pool, 0, poolInfo.queryCount);
+            frame.Scopes.reserve(s_MaxScopesPerFrame);
+        }
+
+        // value + availability per query, two queries per scope
+        m_Results.resize(s_MaxScopesPerFrame * 4);
+    }
+
+    void VulkanGpuProfiler::destroy()
+    {
+        for (auto& frame : m_Frames)
+        {
+            if (frame.Pool)
+                vkDestroyQueryPool(m_Device, frame.Pool, m_Allocator);
+        }
+
+        m_Frames.clear();
+        m_History.clear();
+        m_Supported = false;
+    }
+
+    void VulkanGpuProfiler::beginFrame(uint32_t frameIndex, uint64_t frameNumber)
+    {
+        if (!m_Supported)
+            return;
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        collect(frameIndex);
+
+        FrameQueries& frame = m_Frames[frameIndex];
+        frame.FrameNumber = frameNumber;
+        frame.Scopes.clear();
+
+        m_FrameIndex = frameIndex;
+        m_OpenScopes.clear();
+    }
+
+    void VulkanGpuProfiler::collect(uint32_t frameIndex)
+    {
+        FrameQueries& frame = m_Frames[frameIndex];
+        if (frame.Scopes.empty())
+            return;
+
+        uint32_t queryCount = (uint32_t)frame.Scopes.size() * 2;
+
+        // the frame's fence has signalled so this never blocks; availability covers scopes left open
+        VkResult result = vkGetQueryPoolResults(
+            m_Device, frame.Pool, 0, queryCount,
+            queryCount * 2 * sizeof(uint64_t), m_Results.data(), 2 * sizeof(uint64_t),
+            VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+        vkResetQueryPool(m_Device, frame.Pool, 0, queryCount);
+
+        if (result != VK_SUCCESS && result != VK_NOT_READY)
+            return;
+
+        GpuFrameTimings& timings = m_History.emplace_back();
+        timings.FrameNumber = frame.FrameNumber;
+        timings.Scopes.reserve(frame.Scopes.size());
+
+        for (size_t i = 0; i < frame.Scopes.size(); i++)
+        {
+            const Scope& scope = frame.Scopes[i];
+            const uint64_t* beginQuery = &m_Results[i * 4];
+            const uint64_t* endQuery = &m_Results[i * 4 + 2];
+
+            if (!scope.Closed || !beginQuery[1] || !endQuery[1])
+                continue;
+
+            uint64_t begin = beginQuery[0] & m_TimestampMask;
+            uint64_t end = endQuery[0] & m_TimestampMask;
+            uint64_t ticks = (end - begin) & m_TimestampMask;
+
+            GpuScopeTiming& timing = timings.Scopes.emplace_back();
+            timing.Name = scope.Name;
+            timing.Depth = scope.Depth;
+            timing.Milliseconds = (double)ticks * m_TimestampPeriod / 1000000.0;
+        }
+
+        while (m_History.size() > s_MaxHistory)
+            m_History.pop_front();
+    }
+
+    void VulkanGpuProfiler::beginScope(VkCommandBuffer commandBuffer, const char* name)
+    {
+        if (!m_Supported)
+            return;
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        FrameQueries& frame = m_Frames[m_FrameIndex];
+        auto& openScopes = m_OpenScopes[commandBuffer];
+
+        if (frame.Scopes.size() >= s_MaxScopesPerFrame)
+        {
+            // keep begin/end balanced so endScope() pops the right entry
+            openScopes.push_back(std::numeric_limits<uint32_t>::max());
+            return;
+        }
+
+        uint32_t index = (uint32_t)frame.Scopes.size();
+        frame.Scopes.push_back({ name, (uint32_t)openScopes.size(), false });
+        openScopes.push_back(index);
+
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame.Pool, index * 2);
+    }
+
+    void VulkanGpuProfiler::endScope(VkCommandBuffer commandBuffer)
+    {
+        if (!m_Supported)
+            return;
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        auto it = m_OpenScopes.find(commandBuffer);
+        SIL_ASSERT(it != m_OpenScopes.end() && !it->second.empty(), "endGpuScope() called without a matching beginGpuScope()!");
+        if (it == m_OpenScopes.end() || it->second.empty())
+            return;
+
+        uint32_t index = it->second.back();
+        it->second.pop_back();
+
+        if (index == std::numeric_limits<uint32_t>::max())
+            return;
+
+        FrameQueries& frame = m_Frames[m_FrameIndex];
+        frame.Scopes[index].Closed = true;
+
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.Pool, index * 2 + 1);
+    }
+
+    std::vector<GpuFrameTimings> VulkanGpuProfiler::getFrameTimings(uint32_t frameCount) const
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        size_t count = std::min<size_t>(frameCount, m_History.size());
+        return std::vector<GpuFrameTimings>(m_History.end() - count, m_History.end());
+    }
+
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Renderer/Device.h"
+
+#include <vulkan/vulkan.h>
+
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+namespace silica {
+
+    class VulkanGpuProfiler
+    {
+    public:
+        VulkanGpuProfiler() = default;
+        ~VulkanGpuProfiler() = default;
+
+        void create(VkDevice device, const VkPhysicalDeviceProperties& properties, const VkQueueFamilyProperties& queueFamily, const VkAllocationCallbacks* allocator, uint32_t framesInFlight);
+        void destroy();
+
+        // call once the frame slot's fence has signalled; reads the previous results back without waiting
+        void beginFrame(uint32_t frameIndex, uint64_t frameNumber);
+
+        void beginScope(VkCommandBuffer commandBuffer, const char* name);
+        void endScope(VkCommandBuffer commandBuffer);
+
+        std::vector<GpuFrameTimings> getFrameTimings(uint32_t frameCount) const;
+
+        bool isSupported() const { return m_Supported; }
+    private:
+        void collect(uint32_t frameIndex);
+    private:
+        static constexpr uint32_t s_MaxScopesPerFrame = 512;
+        static constexpr size_t s_MaxHistory = 240;
+
+        struct Scope
+        {
+            std::string Name;
+            uint32_t Depth = 0;
+            bool Closed = false;
+        };
+
+        struct FrameQueries
+        {
+            VkQueryPool Pool = nullptr;
+            uint64_t FrameNumber = 0;
+            std::vector<Scope> Scopes;
+        };
+
+        VkDevice m_Device = nullptr;
+        const VkAllocationCallbacks* m_Allocator = nullptr;
+
+        bool m_Supported = false;
+        double m_TimestampPeriod = 1.0;
+        uint64_t m_TimestampMask = ~0ull;
+
+        std::vector<FrameQueries> m_Frames;
+        uint32_t m_FrameIndex = 0;
+
+        // open scopes per command buffer, so lists recorded in parallel nest independently
+        std::unordered_map<VkCommandBuffer, std::vector<uint32_t>> m_OpenScopes;
+        std::vector<uint64_t> m_Results;
+
+        std::deque<GpuFrameTimings> m_History;
+        mutable std::mutex m_Mutex;
+    };
+
+}
@@ -0,0 +1,320 @@
+#include "VulkanHostAllocator.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+namespace silica {
+
+    // sits directly in front of every pointer handed to the driver
+    struct alignas(16) AllocationHeader
+    {
+        uint64_t Size;
+        // distance from the start of the underlying malloc block, unused for pooled blocks
+        uint32_t Offset;
+        uint8_t Scope;
+        uint8_t SizeClass;
+    };
+
+    static_assert(sizeof(AllocationHeader) == 16);
+
+    static constexpr uint8_t s_NotPooled = 0xFF;
+    static constexpr uint32_t s_SizeClassCount = 7;
+    static constexpr size_t s_SizeClasses[s_SizeClassCount] = { 16, 32, 64, 128, 256, 512, 1024 };
+    static constexpr size_t s_MaxPooledAlignment = alignof(AllocationHeader);
+    static constexpr size_t s_ChunkSize = 64 * 1024;
+    static constexpr uint32_t s_RefillCount = 32;
+    static constexpr uint32_t s_MaxCachedBlocks = 256;
+
+    struct FreeBlock
+    {
+        FreeBlock* Next;
+    };
+
+    struct HostPoolState
+    {
+        std::mutex Mutex;
+        FreeBlock* FreeLists[s_SizeClassCount] = {};
+        std::vector<void*> Chunks;
+
+        ~HostPoolState()
+        {
+            for (void* chunk : Chunks)
+                std::free(chunk);
+        }
+    };
+
+    static HostPoolState& getPoolState()
+    {
+        static HostPoolState state;
+        return state;
+    }
+
+    // blocks freed on a thread are cached there; the cache hands them back to the shared lists when the thread exits
+    struct HostThreadCache
+    {
+        FreeBlock* FreeLists[s_SizeClassCount] = {};
+        uint32_t Counts[s_SizeClassCount] = {};
+
+        ~HostThreadCache()
+        {
+            for (uint32_t i = 0; i < s_SizeClassCount; i++)
+                release(i, Counts[i]);
+        }
+
+        // moves count blocks from the front of the list to the shared pool
+        void release(uint32_t sizeClass, uint32_t count)
+        {
+            if (count == 0)
+                return;
+
+            FreeBlock* first = FreeLists[sizeClass];
+            FreeBlock* last = first;
+            for (uint32_t i = 1; i < count; i++)
+                last = last->Next;
+
+            FreeLists[sizeClass] = last->Next;
+            Counts[sizeClass] -= count;
+
+            auto& state = getPoolState();
+            std::lock_guard<std::mutex> lock(state.Mutex);
+            last->Next = state.FreeLists[sizeClass];
+            state.FreeLists[sizeClass] = first;
+        }
+
+        void refill(uint32_t sizeClass)
+        {
+            size_t blockSize = sizeof(AllocationHeader) + s_SizeClasses[sizeClass];
+
+            auto& state = getPoolState();
+            std::lock_guard<std::mutex> lock(state.Mutex);
+
+            for (uint32_t i = 0; i < s_RefillCount && state.FreeLists[sizeClass]; i++)
+            {
+                FreeBlock* block = state.FreeLists[sizeClass];
+                state.FreeLists[sizeClass] = block->Next;
+                push(sizeClass, block);
+            }
+
+            if (FreeLists[sizeClass])
+                return;
+
+            uint8_t* chunk = static_cast<uint8_t*>(std::malloc(s_ChunkSize));
+            if (!chunk)
+                return;
+
+            state.Chunks.push_back(chunk);
+            for (size_t offset = 0; offset + blockSize <= s_ChunkSize; offset += blockSize)
+                push(sizeClass, reinterpret_cast<FreeBlock*>(chunk + offset));
+        }
+
+        void push(uint32_t sizeClass, FreeBlock* block)
+        {
+            block->Next = FreeLists[sizeClass];
+            FreeLists[sizeClass] = block;
+            Counts[sizeClass]++;
+        }
+
+        FreeBlock* pop(uint32_t sizeClass)
+        {
+            if (!FreeLists[sizeClass])
+                refill(sizeClass);
+
+            FreeBlock* block = FreeLists[sizeClass];
+            if (block)
+            {
+                FreeLists[sizeClass] = block->Next;
+                Counts[sizeClass]--;
+            }
+            return block;
+        }
+    };
+
+    static HostThreadCache& getThreadCache()
+    {
+        // touch the shared state first so it outlives every thread cache
+        getPoolState();
+
+        thread_local HostThreadCache cache;
+        return cache;
+    }
+
+    namespace utils {
+
+        static uint32_t findSizeClass(size_t size, size_t alignment)
+        {
+            if (alignment > s_MaxPooledAlignment)
+                return s_NotPooled;
+
+            for (uint32_t i = 0; i < s_SizeClassCount; i++)
+            {
+                if (size <= s_SizeClasses[i])
+                    return i;
+            }
+            return s_NotPooled;
+        }
+
+        static AllocationHeader* getHeader(void* memory)
+        {
+            return reinterpret_cast<AllocationHeader*>(memory) - 1;
+        }
+
+    }
+
+    VulkanHostAllocator::VulkanHostAllocator()
+    {
+        m_Callbacks.pUserData = this;
+        m_Callbacks.pfnAllocation = &VulkanHostAllocator::allocateMemory;
+        m_Callbacks.pfnReallocation = &VulkanHostAllocator::reallocateMemory;
+        m_Callbacks.pfnFree = &VulkanHostAllocator::freeMemory;
+        m_Callbacks.pfnInternalAllocation = &VulkanHostAllocator::notifyInternalAllocation;
+        m_Callbacks.pfnInternalFree = &VulkanHostAllocator::notifyInternalFree;
+    }
+
+    HostMemoryStats VulkanHostAllocator::getStats() const
+    {
+        HostMemoryStats stats;
+        for (uint32_t i = 0; i < s_ScopeCount; i++)
+        {
+            stats.Scopes[i].Bytes = m_Scopes[i].Bytes.load(std::memory_order_relaxed);
+            stats.Scopes[i].PeakBytes = m_Scopes[i].PeakBytes.load(std::memory_order_relaxed);
+            stats.Scopes[i].Allocations = m_Scopes[i].Allocations.load(std::memory_order_relaxed);
+            stats.Scopes[i].LiveAllocations = m_Scopes[i].LiveAllocations.load(std::memory_order_relaxed);
+        }
+        stats.InternalBytes = m_InternalBytes.load(std::memory_order_relaxed);
+        stats.PooledAllocations = m_PooledAllocations.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    void* VKAPI_CALL VulkanHostAllocator::allocateMemory(void* userData, size_t size, size_t alignment, VkSystemAllocationScope scope)
+    {
+        if (size == 0)
+            return nullptr;
+
+        auto* allocator = static_cast<VulkanHostAllocator*>(userData);
+        alignment = std::max(alignment, alignof(AllocationHeader));
+
+        AllocationHeader* header = nullptr;
+
+        uint32_t sizeClass = utils::findSizeClass(size, alignment);
+        if (sizeClass != s_NotPooled)
+        {
+            header = reinterpret_cast<AllocationHeader*>(getThreadCache().pop(sizeClass));
+            if (header)
+            {
+                header->Offset = 0;
+                allocator->m_PooledAllocations.fetch_add(1, std::memory_order_relaxed);
+            }
+            else
+            {
+                sizeClass = s_NotPooled;
+            }
+        }
+
+        if (!header)
+        {
+            uint8_t* base = static_cast<uint8_t*>(std::malloc(size + alignment + sizeof(AllocationHeader)));
+            if (!base)
+                return nullptr;
+
+            uintptr_t memory = ((uintptr_t)base + sizeof(AllocationHeader) + alignment - 1) & ~(uintptr_t)(alignment - 1);
+            header = utils::getHeader(reinterpret_cast<void*>(memory));
+            header->Offset = (uint32_t)(memory - (uintptr_t)base);
+        }
+
+        header->Size = size;
+        header->Scope = (uint8_t)scope;
+        header->SizeClass = (uint8_t)sizeClass;
+
+        allocator->track(scope, (int64_t)size, 1);
+        return header + 1;
+    }
+
+    void* VKAPI_CALL VulkanHostAllocator::reallocateMemory(void* userData, void* original, size_t size, size_t alignment, VkSystemAllocationScope scope)
+    {
+        if (!original)
+            return allocateMemory(userData, size, alignment, scope);
+
+        if (size == 0)
+        {
+            freeMemory(userData, original);
+            return nullptr;
+        }
+
+        AllocationHeader* header = utils::getHeader(original);
+
+        // still fits the pooled block it already has
+        if (header->SizeClass != s_NotPooled && size <= s_SizeClasses[header->SizeClass] && alignment <= s_MaxPooledAlignment && header->Scope == (uint8_t)scope)
+        {
+            auto* allocator = static_cast<VulkanHostAllocator*>(userData);
+            allocator->track(scope, (int64_t)size - (int64_t)header->Size, 0);
+            header->Size = size;
+            return original;
+        }
+
+        void* memory = allocateMemory(userData, size, alignment, scope);
+        if (!memory)
+            return nullptr;
+
+        std::memcpy(memory, original, std::min<size_t>(size, header->Size));
+        freeMemory(userData, original);
+        return memory;
+    }
+
+    void VKAPI_CALL VulkanHostAllocator::freeMemory(void* userData, void* memory)
+    {
+        if (!memory)
+            return;
+
+        auto* allocator = static_cast<VulkanHostAllocator*>(userData);
+        AllocationHeader* header = utils::getHeader(memory);
+
+        auto scope = (VkSystemAllocationScope)header->Scope;
+        allocator->track(scope, -(int64_t)header->Size, -1);
+
+        if (header->SizeClass != s_NotPooled)
+        {
+            HostThreadCache& cache = getThreadCache();
+            cache.push(header->SizeClass, reinterpret_cast<FreeBlock*>(header));
+
+            // frees on a different thread than the allocations would otherwise pile up here
+            if (cache.Counts[header->SizeClass] > s_MaxCachedBlocks)
+                cache.release(header->SizeClass, s_MaxCachedBlocks / 2);
+            return;
+        }
+
+        std::free(reinterpret_cast<uint8_t*>(memory) - header->Offset);
+    }
+
+    void VKAPI_CALL VulkanHostAllocator::notifyInternalAllocation(void* userData, size_t size, VkInternalAllocationType, VkSystemAllocationScope)
+    {
+        static_cast<VulkanHostAllocator*>(userData)->m_InternalBytes.fetch_add(size, std::memory_order_relaxed);
+    }
+
+    void VKAPI_CALL VulkanHostAllocator::notifyInternalFree(void* userData, size_t size, VkInternalAllocationType, VkSystemAllocationScope)
+    {
+        static_cast<VulkanHostAllocator*>(userData)->m_InternalBytes.fetch_sub(size, std::memory_order_relaxed);
+    }
+
+    void VulkanHostAllocator::track(VkSystemAllocationScope scope, int64_t bytes, int64_t allocations)
+    {
+        ScopeCounters& counters = m_Scopes[std::min<uint32_t>((uint32_t)scope, s_ScopeCount - 1)];
+
+        // unsigned wrap-around turns the adds into subtractions for negative deltas
+        uint64_t current = counters.Bytes.fetch_add((uint64_t)bytes, std::memory_order_relaxed) + (uint64_t)bytes;
+        counters.LiveAllocations.fetch_add((uint64_t)allocations, std::memory_order_relaxed);
+        if (allocations > 0)
+            counters.Allocations.fetch_add((uint64_t)allocations, std::memory_order_relaxed);
+
+        if (bytes <= 0)
+            return;
+
+        uint64_t peak = counters.PeakBytes.load(std::memory_order_relaxed);
+        while (current > peak && !counters.PeakBytes.compare_exchange_weak(peak, current, std::memory_order_relaxed))
+        {
+        }
+    }
+
+}
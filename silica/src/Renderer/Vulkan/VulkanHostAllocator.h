@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Renderer/Instance.h"
+
+#include <vulkan/vulkan.h>
+
+#include <atomic>
+
+namespace silica {
+
+    // VkAllocationCallbacks that count driver host memory per VkSystemAllocationScope.
+    // Small allocations come from thread-local size-class free lists backed by shared
+    // chunks, so the short-lived allocations around swapchain and pipeline creation
+    // do not go through malloc.
+    class VulkanHostAllocator
+    {
+    public:
+        VulkanHostAllocator();
+        ~VulkanHostAllocator() = default;
+
+        VulkanHostAllocator(const VulkanHostAllocator&) = delete;
+        VulkanHostAllocator& operator=(const VulkanHostAllocator&) = delete;
+
+        const VkAllocationCallbacks* getCallbacks() const { return &m_Callbacks; }
+        HostMemoryStats getStats() const;
+    private:
+        static void* VKAPI_CALL allocateMemory(void* userData, size_t size, size_t alignment, VkSystemAllocationScope scope);
+        static void* VKAPI_CALL reallocateMemory(void* userData, void* original, size_t size, size_t alignment, VkSystemAllocationScope scope);
+        static void VKAPI_CALL freeMemory(void* userData, void* memory);
+        static void VKAPI_CALL notifyInternalAllocation(void* userData, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope);
+        static void VKAPI_CALL notifyInternalFree(void* userData, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope);
+
+        void track(VkSystemAllocationScope scope, int64_t bytes, int64_t allocations);
+    private:
+        static constexpr uint32_t s_ScopeCount = VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1;
+
+        struct ScopeCounters
+        {
+            std::atomic<uint64_t> Bytes = 0;
+            std::atomic<uint64_t> PeakBytes = 0;
+            std::atomic<uint64_t> Allocations = 0;
+            std::atomic<uint64_t> LiveAllocations = 0;
+        };
+
+        VkAllocationCallbacks m_Callbacks{};
+
+        ScopeCounters m_Scopes[s_ScopeCount];
+        std::atomic<uint64_t> m_InternalBytes = 0;
+        std::atomic<uint64_t> m_PooledAllocations = 0;
+    };
+
+}
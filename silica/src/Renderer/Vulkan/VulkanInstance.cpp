@@ -1,6 +1,7 @@
 #include "VulkanInstance.h"
 
 #include "VulkanDevice.h"
+#include "Core/Profiler.h"
 
 #include <vulkan/vulkan.h>
 
@@ -27,12 +28,17 @@ namespace silica {
 
     namespace utils {
 
-        std::vector<const char*> getRequiredInstanceExtensions()
+        std::vector<const char*> getRequiredInstanceExtensions(bool headless)
         {
-            uint32_t glfwExtensionCount = 0;
-            const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+            std::vector<const char*> extensions;
 
-            std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+            if (!headless)
+            {
+                uint32_t glfwExtensionCount = 0;
+                const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+
+                extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+            }
 
             if (s_EnableValidationLayers)
             {
@@ -129,23 +135,54 @@ namespace silica {
     VulkanInstance::VulkanInstance(const InstanceInfo& instanceInfo)
         : m_Info(instanceInfo)
     {
+        if (m_Info.TrackHostAllocations)
+        {
+            m_HostAllocator = std::make_unique<VulkanHostAllocator>();
+            m_Allocator = m_HostAllocator->getCallbacks();
+        }
+
         createInstance();
-        createSurface();
+
+        if (!m_Info.Headless)
+            createSurface();
     }
 
     VulkanInstance::~VulkanInstance()
     {
         for (auto& resource : m_Resources)
         {
+            // already retired through a device's release queue
+            if (!resource->isValid())
+                continue;
+
             resource->destroy();
             resource->invalidate();
         }
         m_Resources.clear();
 
-        vkDestroySurfaceKHR(m_Instance, m_Surface, m_Allocator);
+        if (m_Surface)
+            vkDestroySurfaceKHR(m_Instance, m_Surface, m_Allocator);
         if constexpr (s_EnableValidationLayers)
             utils::destroyDebugUtilsMessengerEXT(m_Instance, m_DebugMessenger, m_Allocator);
         vkDestroyInstance(m_Instance, m_Allocator);
+
+        if (m_HostAllocator)
+        {
+            static const char* s_ScopeNames[] = { "command", "object", "cache", "device", "instance" };
+
+            HostMemoryStats stats = m_HostAllocator->getStats();
+            for (uint32_t i = 0; i < 5; i++)
+            {
+                const HostMemoryStats::Scope& scope = stats.Scopes[i];
+                SIL_DEBUG_LOG("Driver host memory ({} scope): peak {} bytes, {} allocations, {} bytes still live", s_ScopeNames[i], scope.PeakBytes, scope.Allocations, scope.Bytes);
+            }
+            SIL_DEBUG_LOG("Driver host memory: {} allocations served from pools", stats.PooledAllocations);
+        }
+    }
+
+    HostMemoryStats VulkanInstance::getHostMemoryStats() const
+    {
+        return m_HostAllocator ? m_HostAllocator->getStats() : HostMemoryStats{};
     }
 
     std::shared_ptr<Device> VulkanInstance::createDevice(const DeviceInfo& deviceInfo)
@@ -158,6 +195,8 @@ namespace silica {
 
     void VulkanInstance::createInstance()
     {
+        SIL_PROFILE_FUNCTION();
+
         VkApplicationInfo appInfo{};
         appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
         appInfo.pApplicationName = "cNom";
@@ -170,14 +209,14 @@ namespace silica {
         instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
         instanceInfo.pApplicationInfo = &appInfo;
 
-        std::vector<const char*> extensions = utils::getRequiredInstanceExtensions();
+        m_Extensions = utils::getRequiredInstanceExtensions(m_Info.Headless);
         
 #ifdef SIL_PLATFORM_MAC
         instanceInfo.flags = VK_INSTANCE_CREATE_ENUMERATE_PORTABILITY_BIT_KHR;
 #endif
         
-        instanceInfo.enabledExtensionCount = (uint32_t)extensions.size();
-        instanceInfo.ppEnabledExtensionNames = extensions.data();
+        instanceInfo.enabledExtensionCount = (uint32_t)m_Extensions.size();
+        instanceInfo.ppEnabledExtensionNames = m_Extensions.data();
 
         VkDebugUtilsMessengerCreateInfoEXT debugCreateInfo{};
         if constexpr (s_EnableValidationLayers)
@@ -205,10 +244,10 @@ namespace silica {
 
         vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, instanceExtensions.data());
 
-        SIL_INFO("Available extensions:");
+        SIL_TRACE("Available extensions:");
         for (const auto& extension : instanceExtensions)
         {
-            SIL_INFO("\t{}", extension.extensionName);
+            SIL_TRACE("\t{}", extension.extensionName);
         }
 
         if constexpr (s_EnableValidationLayers)
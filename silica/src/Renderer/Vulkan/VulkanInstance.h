@@ -1,12 +1,14 @@
 #pragma once
 
 #include "VulkanExtensions.h"
+#include "VulkanHostAllocator.h"
 
 #include "Core/Assert.h"
 #include "Renderer/Instance.h"
 
 #include <vulkan/vulkan.h>
 
+#include <memory>
 #include <vector>
 
 namespace silica {
@@ -35,12 +37,15 @@ namespace silica {
         virtual ~VulkanInstance();
 
         virtual std::shared_ptr<Device> createDevice(const DeviceInfo& deviceInfo) override;
+        virtual HostMemoryStats getHostMemoryStats() const override;
 
         VkInstance getInstance() const { return m_Instance; }
         const VkAllocationCallbacks* getAllocator() const { return m_Allocator; }
         VkDebugUtilsMessengerEXT getDebugMessenger() const { return m_DebugMessenger; }
         VkSurfaceKHR getSurface() const { return m_Surface; }
         GLFWwindow* getWindow() const { return m_Info.Window; }
+        bool isHeadless() const { return m_Info.Headless; }
+        const std::vector<const char*>& getEnabledExtensions() const { return m_Extensions; }
     private:
         void createInstance();
         void createSurface();
@@ -48,9 +53,13 @@ namespace silica {
         InstanceInfo m_Info;
 
         VkInstance m_Instance = nullptr;
-        VkAllocationCallbacks* m_Allocator = nullptr;
+        // null (the driver allocates on its own) unless InstanceInfo::TrackHostAllocations is set
+        const VkAllocationCallbacks* m_Allocator = nullptr;
+        std::unique_ptr<VulkanHostAllocator> m_HostAllocator;
         VkDebugUtilsMessengerEXT m_DebugMessenger = nullptr;
         VkSurfaceKHR m_Surface = nullptr;
+
+        std::vector<const char*> m_Extensions;
         
         std::vector<std::shared_ptr<Resource>> m_Resources;
     };
@@ -58,7 +67,7 @@ namespace silica {
     namespace utils {
         
         bool checkValidationLayerSupport();
-        std::vector<const char*> getRequiredInstanceExtensions();
+        std::vector<const char*> getRequiredInstanceExtensions(bool headless);
 
     }
 
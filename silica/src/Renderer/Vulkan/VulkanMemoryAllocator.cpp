@@ -0,0 +1,379 @@
+#include "VulkanMemoryAllocator.h"
+
+#include "Core/Log.h"
+#include "Core/Profiler.h"
+
+#include <algorithm>
+
+namespace silica {
+
+    namespace utils {
+
+        static uint64_t alignUpPow2(uint64_t value, uint64_t alignment)
+        {
+            alignment = std::max<uint64_t>(alignment, 1);
+            return (value + alignment - 1) & ~(alignment - 1);
+        }
+
+    }
+
+    void VulkanMemoryAllocator::create(nvrhi::IDevice* device, VulkanMemoryBudget* budget, uint64_t blockSize, uint64_t transientSize)
+    {
+        m_Device = device;
+        m_Budget = budget;
+        m_BlockSize = blockSize;
+        m_TransientSize = transientSize;
+    }
+
+    void VulkanMemoryAllocator::destroy()
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        // resources go before the heaps they are bound to
+        for (auto& [resource, placement] : m_Placements)
+            free(placement);
+        m_Placements.clear();
+
+        for (PendingRelease& pending : m_PendingReleases)
+            free(pending.Resource);
+        m_PendingReleases.clear();
+
+        for (TransientFrame& frame : m_TransientFrames)
+        {
+            for (Placement& placement : frame.Placements)
+                free(placement);
+        }
+        m_TransientFrames.clear();
+
+        for (Placement& placement : m_CurrentTransientFrame.Placements)
+            free(placement);
+        m_CurrentTransientFrame = {};
+
+        for (size_t i = 0; i < (size_t)ResourceKind::Count; i++)
+        {
+            m_Blocks[i].clear();
+            m_TransientRings[i] = {};
+        }
+
+        m_Stats = {};
+        m_Device = nullptr;
+    }
+
+    void VulkanMemoryAllocator::beginFrame(uint64_t completedValue)
+    {
+        SIL_PROFILE_FUNCTION();
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        while (!m_PendingReleases.empty() && m_PendingReleases.front().GpuValue <= completedValue)
+        {
+            free(m_PendingReleases.front().Resource);
+            m_PendingReleases.pop_front();
+        }
+
+        while (!m_TransientFrames.empty() && m_TransientFrames.front().GpuValue <= completedValue)
+        {
+            TransientFrame& frame = m_TransientFrames.front();
+            for (Placement& placement : frame.Placements)
+                free(placement);
+
+            for (size_t i = 0; i < (size_t)ResourceKind::Count; i++)
+                m_TransientRings[i].Tail = frame.RingHeads[i];
+
+            m_TransientFrames.pop_front();
+        }
+    }
+
+    void VulkanMemoryAllocator::endFrame(uint64_t frameValue)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        if (m_CurrentTransientFrame.Placements.empty())
+            return;
+
+        m_CurrentTransientFrame.GpuValue = frameValue;
+        for (size_t i = 0; i < (size_t)ResourceKind::Count; i++)
+            m_CurrentTransientFrame.RingHeads[i] = m_TransientRings[i].Head;
+
+        m_TransientFrames.push_back(std::move(m_CurrentTransientFrame));
+        m_CurrentTransientFrame = {};
+    }
+
+    nvrhi::IBuffer* VulkanMemoryAllocator::createBuffer(const nvrhi::BufferDesc& desc, MemoryStrategy strategy)
+    {
+        SIL_PROFILE_FUNCTION();
+
+        Placement placement;
+        placement.Kind = ResourceKind::Buffer;
+        placement.Category = MemoryCategory::Buffer;
+
+        // nvrhi can only map buffers that own their memory, and volatile buffers have none
+        bool placeable = desc.cpuAccess == nvrhi::CpuAccessMode::None && !desc.isVolatile;
+
+        nvrhi::BufferHandle buffer;
+        if (placeable)
+        {
+            nvrhi::BufferDesc virtualDesc = desc;
+            virtualDesc.isVirtual = true;
+            buffer = m_Device->createBuffer(virtualDesc);
+        }
+
+        if (buffer)
+        {
+            nvrhi::MemoryRequirements requirements = m_Device->getBufferMemoryRequirements(buffer);
+            placement.Size = requirements.size;
+
+            std::lock_guard<std::mutex> lock(m_Mutex);
+
+            nvrhi::IHeap* heap = nullptr;
+            uint64_t offset = 0;
+            if (place(ResourceKind::Buffer, requirements, strategy, placement, heap, offset) && m_Device->bindBufferMemory(buffer, heap, offset))
+            {
+                placement.Resource = buffer;
+                track(std::move(placement), strategy);
+                return buffer;
+            }
+
+            if (placement.Owner)
+                placement.Owner->Allocator.free(placement.Allocation);
+            placement.Owner = nullptr;
+        }
+
+        buffer = m_Device->createBuffer(desc);
+        if (!buffer)
+            return nullptr;
+
+        placement.Size = desc.byteSize;
+        placement.Resource = buffer;
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        track(std::move(placement), strategy);
+        return buffer;
+    }
+
+    nvrhi::ITexture* VulkanMemoryAllocator::createTexture(const nvrhi::TextureDesc& desc, MemoryStrategy strategy)
+    {
+        SIL_PROFILE_FUNCTION();
+
+        Placement placement;
+        placement.Kind = ResourceKind::Texture;
+        placement.Category = desc.isRenderTarget ? MemoryCategory::RenderTarget : MemoryCategory::Texture;
+
+        nvrhi::TextureDesc virtualDesc = desc;
+        virtualDesc.isVirtual = true;
+        nvrhi::TextureHandle texture = m_Device->createTexture(virtualDesc);
+
+        if (texture)
+        {
+            nvrhi::MemoryRequirements requirements = m_Device->getTextureMemoryRequirements(texture);
+            placement.Size = requirements.size;
+
+            std::lock_guard<std::mutex> lock(m_Mutex);
+
+            nvrhi::IHeap* heap = nullptr;
+            uint64_t offset = 0;
+            if (place(ResourceKind::Texture, requirements, strategy, placement, heap, offset) && m_Device->bindTextureMemory(texture, heap, offset))
+            {
+                placement.Resource = texture;
+                track(std::move(placement), strategy);
+                return texture;
+            }
+
+            if (placement.Owner)
+                placement.Owner->Allocator.free(placement.Allocation);
+            placement.Owner = nullptr;
+        }
+
+        texture = m_Device->createTexture(desc);
+        if (!texture)
+            return nullptr;
+
+        placement.Size = m_Device->getTextureMemoryRequirements(texture).size;
+        placement.Resource = texture;
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        track(std::move(placement), strategy);
+        return texture;
+    }
+
+    void VulkanMemoryAllocator::release(nvrhi::IResource* resource, uint64_t gpuValue)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        auto it = m_Placements.find(resource);
+        if (it == m_Placements.end())
+        {
+            SIL_WARN("Released a resource that was not placed by the memory allocator (or is transient)");
+            return;
+        }
+
+        m_PendingReleases.push_back({ gpuValue, std::move(it->second) });
+        m_Placements.erase(it);
+    }
+
+    MemoryAllocatorStats VulkanMemoryAllocator::getStats() const
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_Stats;
+    }
+
+    bool VulkanMemoryAllocator::place(ResourceKind kind, const nvrhi::MemoryRequirements& requirements, MemoryStrategy strategy, Placement& placement, nvrhi::IHeap*& heap, uint64_t& offset)
+    {
+        if (requirements.size == 0 || requirements.size > m_BlockSize / 2)
+            return false;
+
+        if (strategy == MemoryStrategy::Transient && placeTransient(kind, requirements, heap, offset))
+            return true;
+
+        auto& blocks = m_Blocks[(size_t)kind];
+        for (auto& block : blocks)
+        {
+            TLSFAllocator::Allocation allocation = block->Allocator.allocate(requirements.size, requirements.alignment);
+            if (allocation.isValid())
+            {
+                placement.Owner = block.get();
+                placement.Allocation = allocation;
+                heap = block->Heap;
+                offset = allocation.Offset;
+                return true;
+            }
+        }
+
+        nvrhi::HeapDesc heapDesc = nvrhi::HeapDesc()
+            .setCapacity(m_BlockSize)
+            .setType(nvrhi::HeapType::DeviceLocal)
+            .setDebugName(kind == ResourceKind::Buffer ? "Buffer Memory Block" : "Texture Memory Block");
+
+        auto block = std::make_unique<Block>();
+        block->Heap = m_Device->createHeap(heapDesc);
+        if (!block->Heap)
+            return false;
+
+        block->Allocator.reset(m_BlockSize);
+
+        TLSFAllocator::Allocation allocation = block->Allocator.allocate(requirements.size, requirements.alignment);
+        placement.Owner = block.get();
+        placement.Allocation = allocation;
+        heap = block->Heap;
+        offset = allocation.Offset;
+
+        blocks.push_back(std::move(block));
+        m_Stats.Blocks++;
+        m_Stats.BlockBytes += m_BlockSize;
+
+        SIL_DEBUG_LOG("Allocated {} MiB {} memory block ({} blocks in total)", m_BlockSize >> 20, kind == ResourceKind::Buffer ? "buffer" : "texture", m_Stats.Blocks);
+        return true;
+    }
+
+    bool VulkanMemoryAllocator::placeTransient(ResourceKind kind, const nvrhi::MemoryRequirements& requirements, nvrhi::IHeap*& heap, uint64_t& offset)
+    {
+        if (requirements.size > m_TransientSize)
+            return false;
+
+        TransientRing& ring = m_TransientRings[(size_t)kind];
+        if (!ring.Heap)
+        {
+            nvrhi::HeapDesc heapDesc = nvrhi::HeapDesc()
+                .setCapacity(m_TransientSize)
+                .setType(nvrhi::HeapType::DeviceLocal)
+                .setDebugName(kind == ResourceKind::Buffer ? "Transient Buffer Ring" : "Transient Texture Ring");
+
+            ring.Heap = m_Device->createHeap(heapDesc);
+            if (!ring.Heap)
+                return false;
+        }
+
+        uint64_t position = ring.Head;
+        uint64_t ringOffset = utils::alignUpPow2(position % m_TransientSize, requirements.alignment);
+
+        // never wrap a resource around the end of the ring
+        if (ringOffset + requirements.size > m_TransientSize)
+            ringOffset = m_TransientSize;
+
+        position += ringOffset - position % m_TransientSize;
+        if (ringOffset == m_TransientSize)
+            ringOffset = 0;
+
+        if (position + requirements.size - ring.Tail > m_TransientSize)
+            return false;
+
+        ring.Head = position + requirements.size;
+        heap = ring.Heap;
+        offset = ringOffset;
+        return true;
+    }
+
+    void VulkanMemoryAllocator::track(Placement&& placement, MemoryStrategy strategy)
+    {
+        if (m_Budget)
+            m_Budget->track(placement.Category, (int64_t)placement.Size);
+
+        placement.Transient = strategy == MemoryStrategy::Transient;
+        if (placement.Transient)
+        {
+            m_Stats.TransientResources++;
+            m_Stats.TransientBytes += placement.Size;
+            m_CurrentTransientFrame.Placements.push_back(std::move(placement));
+            return;
+        }
+
+        if (placement.Owner)
+        {
+            m_Stats.PlacedResources++;
+            m_Stats.PlacedBytes += placement.Size;
+        }
+        else
+        {
+            m_Stats.DedicatedResources++;
+        }
+
+        nvrhi::IResource* resource = placement.Resource;
+        m_Placements[resource] = std::move(placement);
+    }
+
+    void VulkanMemoryAllocator::free(Placement& placement)
+    {
+        if (!placement.Resource)
+            return;
+
+        // the resource has to be gone before its memory is handed out again
+        placement.Resource = nullptr;
+
+        if (m_Budget)
+            m_Budget->track(placement.Category, -(int64_t)placement.Size);
+
+        if (placement.Transient)
+        {
+            m_Stats.TransientResources--;
+            m_Stats.TransientBytes -= placement.Size;
+        }
+        else if (placement.Owner)
+        {
+            m_Stats.PlacedResources--;
+            m_Stats.PlacedBytes -= placement.Size;
+        }
+        else
+        {
+            m_Stats.DedicatedResources--;
+        }
+
+        Block* owner = placement.Owner;
+        placement.Owner = nullptr;
+        if (!owner)
+            return;
+
+        owner->Allocator.free(placement.Allocation);
+
+        // keep one block per kind around so a scene reload doesn't reallocate immediately
+        auto& blocks = m_Blocks[(size_t)placement.Kind];
+        if (owner->Allocator.isEmpty() && blocks.size() > 1)
+        {
+            auto it = std::find_if(blocks.begin(), blocks.end(), [owner](const std::unique_ptr<Block>& block) { return block.get() == owner; });
+            blocks.erase(it);
+
+            m_Stats.Blocks--;
+            m_Stats.BlockBytes -= m_BlockSize;
+        }
+    }
+
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "VulkanMemoryBudget.h"
+#include "Core/TLSFAllocator.h"
+#include "Renderer/Device.h"
+
+#include <nvrhi/nvrhi.h>
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace silica {
+
+    // Places nvrhi virtual resources into large device-local heaps. General placements are
+    // TLSF sub-allocations released explicitly; transient ones are bump-allocated from a ring
+    // and reclaimed with their frame. Buffers and textures never share a block, so linear and
+    // optimal resources can't end up within the same bufferImageGranularity page.
+    class VulkanMemoryAllocator
+    {
+    public:
+        VulkanMemoryAllocator() = default;
+        ~VulkanMemoryAllocator() = default;
+
+        void create(nvrhi::IDevice* device, VulkanMemoryBudget* budget, uint64_t blockSize, uint64_t transientSize);
+        // the GPU must be idle
+        void destroy();
+
+        // frees released and transient placements of submissions up to completedValue
+        void beginFrame(uint64_t completedValue);
+        // tags this frame's transient placements with the value its submission signals
+        void endFrame(uint64_t frameValue);
+
+        nvrhi::IBuffer* createBuffer(const nvrhi::BufferDesc& desc, MemoryStrategy strategy);
+        nvrhi::ITexture* createTexture(const nvrhi::TextureDesc& desc, MemoryStrategy strategy);
+        void release(nvrhi::IResource* resource, uint64_t gpuValue);
+
+        MemoryAllocatorStats getStats() const;
+    private:
+        enum class ResourceKind
+        {
+            Buffer = 0,
+            Texture,
+            Count
+        };
+
+        struct Block
+        {
+            nvrhi::HeapHandle Heap;
+            TLSFAllocator Allocator;
+        };
+
+        struct TransientRing
+        {
+            nvrhi::HeapHandle Heap;
+            // monotonic byte positions; the live region is [Tail, Head)
+            uint64_t Head = 0;
+            uint64_t Tail = 0;
+        };
+
+        struct Placement
+        {
+            nvrhi::ResourceHandle Resource;
+            ResourceKind Kind = ResourceKind::Buffer;
+            MemoryCategory Category = MemoryCategory::Buffer;
+            uint64_t Size = 0;
+            bool Transient = false;
+            // null for dedicated placements and ones in a transient ring
+            Block* Owner = nullptr;
+            TLSFAllocator::Allocation Allocation;
+        };
+
+        struct TransientFrame
+        {
+            uint64_t GpuValue = 0;
+            uint64_t RingHeads[(size_t)ResourceKind::Count] = {};
+            std::vector<Placement> Placements;
+        };
+
+        struct PendingRelease
+        {
+            uint64_t GpuValue = 0;
+            Placement Resource;
+        };
+
+        // returns the heap and offset to bind at, or false to fall back to a dedicated allocation
+        bool place(ResourceKind kind, const nvrhi::MemoryRequirements& requirements, MemoryStrategy strategy, Placement& placement, nvrhi::IHeap*& heap, uint64_t& offset);
+        bool placeTransient(ResourceKind kind, const nvrhi::MemoryRequirements& requirements, nvrhi::IHeap*& heap, uint64_t& offset);
+        void track(Placement&& placement, MemoryStrategy strategy);
+        void free(Placement& placement);
+    private:
+        nvrhi::IDevice* m_Device = nullptr;
+        VulkanMemoryBudget* m_Budget = nullptr;
+        uint64_t m_BlockSize = 0;
+        uint64_t m_TransientSize = 0;
+
+        std::vector<std::unique_ptr<Block>> m_Blocks[(size_t)ResourceKind::Count];
+        TransientRing m_TransientRings[(size_t)ResourceKind::Count];
+
+        std::unordered_map<nvrhi::IResource*, Placement> m_Placements;
+        std::deque<PendingRelease> m_PendingReleases;
+
+        TransientFrame m_CurrentTransientFrame;
+        std::deque<TransientFrame> m_TransientFrames;
+
+        MemoryAllocatorStats m_Stats;
+        mutable std::mutex m_Mutex;
+    };
+
+}
@@ -0,0 +1,119 @@
+#include "VulkanMemoryBudget.h"
+
+#include "Core/Profiler.h"
+
+#include <algorithm>
+
+namespace silica {
+
+    void VulkanMemoryBudget::create(VkPhysicalDevice physicalDevice, bool budgetExtensionEnabled, const std::vector<float>& thresholds)
+    {
+        m_PhysicalDevice = physicalDevice;
+        m_ExtensionEnabled = budgetExtensionEnabled;
+
+        m_Thresholds = thresholds;
+        std::sort(m_Thresholds.begin(), m_Thresholds.end());
+
+        update();
+
+        for (uint32_t i = 0; i < (uint32_t)m_Budget.Heaps.size(); i++)
+        {
+            const MemoryHeapBudget& heap = m_Budget.Heaps[i];
+            SIL_DEBUG_LOG("Memory heap {}: {} MiB{}, budget {} MiB", i, heap.Size >> 20, heap.DeviceLocal ? " device local" : "", heap.Budget >> 20);
+        }
+    }
+
+    void VulkanMemoryBudget::update()
+    {
+        SIL_PROFILE_FUNCTION();
+
+        VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+        budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+        VkPhysicalDeviceMemoryProperties2 properties{};
+        properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+        properties.pNext = m_ExtensionEnabled ? &budgetProperties : nullptr;
+
+        vkGetPhysicalDeviceMemoryProperties2(m_PhysicalDevice, &properties);
+
+        const VkPhysicalDeviceMemoryProperties& memoryProperties = properties.memoryProperties;
+
+        std::vector<MemoryBudgetEvent> events;
+        MemoryBudgetCallback callback;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+
+            m_Budget.DriverReported = m_ExtensionEnabled;
+            m_Budget.Heaps.resize(memoryProperties.memoryHeapCount);
+            m_CrossedThresholds.resize(memoryProperties.memoryHeapCount, 0);
+
+            int64_t engineBytes = 0;
+            for (size_t i = 0; i < (size_t)MemoryCategory::Count; i++)
+            {
+                m_Budget.CategoryBytes[i] = (uint64_t)std::max<int64_t>(0, m_CategoryBytes[i].load(std::memory_order_relaxed));
+                engineBytes += (int64_t)m_Budget.CategoryBytes[i];
+            }
+
+            bool estimateAssigned = false;
+            for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++)
+            {
+                MemoryHeapBudget& heap = m_Budget.Heaps[i];
+                heap.Size = memoryProperties.memoryHeaps[i].size;
+                heap.DeviceLocal = (memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+
+                if (m_ExtensionEnabled)
+                {
+                    heap.Budget = budgetProperties.heapBudget[i];
+                    heap.Usage = budgetProperties.heapUsage[i];
+                }
+                else
+                {
+                    // without driver numbers everything the engine tracked is charged to the first device-local heap
+                    heap.Budget = heap.Size;
+                    heap.Usage = heap.DeviceLocal && !estimateAssigned ? (uint64_t)engineBytes : 0;
+                    estimateAssigned |= heap.DeviceLocal;
+                }
+
+                if (!heap.DeviceLocal || heap.Budget == 0)
+                    continue;
+
+                float fraction = (float)((double)heap.Usage / (double)heap.Budget);
+                uint32_t crossed = (uint32_t)(std::upper_bound(m_Thresholds.begin(), m_Thresholds.end(), fraction) - m_Thresholds.begin());
+
+                // only rising edges are reported; falling back below a threshold re-arms it
+                for (uint32_t t = m_CrossedThresholds[i]; t < crossed; t++)
+                    events.push_back({ i, m_Thresholds[t], heap.Usage, heap.Budget });
+
+                m_CrossedThresholds[i] = crossed;
+            }
+
+            callback = m_Callback;
+        }
+
+        for (const MemoryBudgetEvent& event : events)
+        {
+            SIL_WARN("Memory heap {} is over {:.0f}% of its budget ({} / {} MiB)", event.HeapIndex, event.Threshold * 100.0f, event.Usage >> 20, event.Budget >> 20);
+
+            if (callback)
+                callback(event);
+        }
+    }
+
+    MemoryBudget VulkanMemoryBudget::getBudget() const
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_Budget;
+    }
+
+    void VulkanMemoryBudget::track(MemoryCategory category, int64_t bytes)
+    {
+        m_CategoryBytes[(size_t)category].fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    void VulkanMemoryBudget::setCallback(MemoryBudgetCallback callback)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Callback = std::move(callback);
+    }
+
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Renderer/Device.h"
+
+#include <vulkan/vulkan.h>
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace silica {
+
+    // Per-heap usage and budget from VK_EXT_memory_budget, plus engine-side accounting
+    // by resource category. Without the extension the engine's own totals stand in for
+    // device-local usage.
+    class VulkanMemoryBudget
+    {
+    public:
+        VulkanMemoryBudget() = default;
+        ~VulkanMemoryBudget() = default;
+
+        void create(VkPhysicalDevice physicalDevice, bool budgetExtensionEnabled, const std::vector<float>& thresholds);
+
+        // queries the driver and raises the callback for thresholds crossed since the last update
+        void update();
+
+        MemoryBudget getBudget() const;
+        void track(MemoryCategory category, int64_t bytes);
+        void setCallback(MemoryBudgetCallback callback);
+    private:
+        VkPhysicalDevice m_PhysicalDevice = nullptr;
+        bool m_ExtensionEnabled = false;
+
+        std::vector<float> m_Thresholds;
+        // per heap, how many thresholds are currently exceeded
+        std::vector<uint32_t> m_CrossedThresholds;
+
+        std::atomic<int64_t> m_CategoryBytes[(size_t)MemoryCategory::Count] = {};
+
+        MemoryBudget m_Budget;
+        MemoryBudgetCallback m_Callback;
+        mutable std::mutex m_Mutex;
+    };
+
+}
@@ -0,0 +1,194 @@
+#include "VulkanPipelineCache.h"
+#include "VulkanInstance.h"
+
+#include "Core/Log.h"
+#include "Core/Profiler.h"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace silica {
+
+    namespace utils {
+
+        static double millisecondsSince(std::chrono::steady_clock::time_point start)
+        {
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+    }
+
+    VulkanPipelineCache* VulkanPipelineCache::s_Hooked = nullptr;
+
+    void VulkanPipelineCache::create(VkDevice device, const VkPhysicalDeviceProperties& properties, const VkAllocationCallbacks* allocator, const std::string& path)
+    {
+        SIL_PROFILE_FUNCTION();
+
+        m_Device = device;
+        m_Allocator = allocator;
+        m_Path = path;
+        m_Properties = properties;
+
+        auto start = std::chrono::steady_clock::now();
+
+        std::vector<char> data;
+        if (!m_Path.empty())
+        {
+            std::ifstream file(m_Path, std::ios::binary | std::ios::ate);
+            if (file.is_open())
+            {
+                data.resize((size_t)file.tellg());
+                file.seekg(0);
+                file.read(data.data(), data.size());
+
+                if (!file || !validateHeader(data))
+                {
+                    SIL_WARN("Pipeline cache '{}' is invalid or was written by a different device/driver, starting empty", m_Path);
+                    data.clear();
+                }
+            }
+        }
+
+        VkPipelineCacheCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        createInfo.initialDataSize = data.size();
+        createInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+        VkResult result = vkCreatePipelineCache(m_Device, &createInfo, m_Allocator, &m_Cache);
+        if (result != VK_SUCCESS && !data.empty())
+        {
+            // the driver may still reject data that passed the header check
+            SIL_WARN("Driver rejected pipeline cache '{}', starting empty", m_Path);
+            data.clear();
+            createInfo.initialDataSize = 0;
+            createInfo.pInitialData = nullptr;
+            result = vkCreatePipelineCache(m_Device, &createInfo, m_Allocator, &m_Cache);
+        }
+        VK_CHECK(result, "Failed to create pipeline cache!");
+
+        m_Stats.Loaded = !data.empty();
+        m_Stats.LoadedBytes = data.size();
+        m_Stats.LoadMilliseconds = utils::millisecondsSince(start);
+
+        if (m_Stats.Loaded)
+            SIL_INFO("Pipeline cache: loaded {} bytes from '{}' in {:.2f} ms", m_Stats.LoadedBytes, m_Path, m_Stats.LoadMilliseconds);
+        else
+            SIL_INFO("Pipeline cache: starting empty, pipelines compile from scratch ({:.2f} ms spent checking)", m_Stats.LoadMilliseconds);
+    }
+
+    void VulkanPipelineCache::save()
+    {
+        SIL_PROFILE_FUNCTION();
+
+        if (!m_Cache || m_Path.empty())
+            return;
+
+        auto start = std::chrono::steady_clock::now();
+
+        size_t size = 0;
+        vkGetPipelineCacheData(m_Device, m_Cache, &size, nullptr);
+
+        std::vector<char> data(size);
+        if (size == 0 || vkGetPipelineCacheData(m_Device, m_Cache, &size, data.data()) != VK_SUCCESS)
+        {
+            SIL_WARN("Failed to read pipeline cache data, '{}' was not updated", m_Path);
+            return;
+        }
+
+        // a crash mid-write must never leave a truncated cache behind
+        std::string tempPath = m_Path + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            file.write(data.data(), size);
+            if (!file)
+            {
+                SIL_WARN("Failed to write pipeline cache to '{}'", tempPath);
+                return;
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::rename(tempPath, m_Path, error);
+        if (error)
+        {
+            SIL_WARN("Failed to replace pipeline cache '{}': {}", m_Path, error.message());
+            std::filesystem::remove(tempPath, error);
+            return;
+        }
+
+        m_Stats.SavedBytes = size;
+        m_Stats.SaveMilliseconds = utils::millisecondsSince(start);
+
+        SIL_INFO("Saved {} bytes of pipeline cache ({} pipelines created this run) to '{}' in {:.2f} ms",
+            m_Stats.SavedBytes, m_CreatedPipelines.load(), m_Path, m_Stats.SaveMilliseconds);
+    }
+
+    void VulkanPipelineCache::destroy()
+    {
+        if (s_Hooked == this)
+        {
+            m_Dispatch->vkCreateGraphicsPipelines = m_CreateGraphicsPipelines;
+            m_Dispatch->vkCreateComputePipelines = m_CreateComputePipelines;
+            m_Dispatch = nullptr;
+            s_Hooked = nullptr;
+        }
+
+        if (m_Cache)
+            vkDestroyPipelineCache(m_Device, m_Cache, m_Allocator);
+
+        m_Cache = nullptr;
+    }
+
+    void VulkanPipelineCache::hookDispatch(vk::detail::DispatchLoaderDynamic& dispatch)
+    {
+        SIL_ASSERT(!s_Hooked, "Another pipeline cache is already hooked into the dispatcher");
+
+        m_Dispatch = &dispatch;
+        m_CreateGraphicsPipelines = dispatch.vkCreateGraphicsPipelines;
+        m_CreateComputePipelines = dispatch.vkCreateComputePipelines;
+        dispatch.vkCreateGraphicsPipelines = &VulkanPipelineCache::createGraphicsPipelines;
+        dispatch.vkCreateComputePipelines = &VulkanPipelineCache::createComputePipelines;
+        s_Hooked = this;
+    }
+
+    PipelineCacheStats VulkanPipelineCache::getStats() const
+    {
+        PipelineCacheStats stats = m_Stats;
+        stats.CreatedPipelines = m_CreatedPipelines.load();
+        return stats;
+    }
+
+    VkResult VulkanPipelineCache::createGraphicsPipelines(VkDevice device, VkPipelineCache cache, uint32_t count,
+        const VkGraphicsPipelineCreateInfo* createInfos, const VkAllocationCallbacks* allocator, VkPipeline* pipelines)
+    {
+        VulkanPipelineCache* self = s_Hooked;
+        self->m_CreatedPipelines += count;
+        return self->m_CreateGraphicsPipelines(device, cache ? cache : self->m_Cache, count, createInfos, allocator, pipelines);
+    }
+
+    VkResult VulkanPipelineCache::createComputePipelines(VkDevice device, VkPipelineCache cache, uint32_t count,
+        const VkComputePipelineCreateInfo* createInfos, const VkAllocationCallbacks* allocator, VkPipeline* pipelines)
+    {
+        VulkanPipelineCache* self = s_Hooked;
+        self->m_CreatedPipelines += count;
+        return self->m_CreateComputePipelines(device, cache ? cache : self->m_Cache, count, createInfos, allocator, pipelines);
+    }
+
+    bool VulkanPipelineCache::validateHeader(const std::vector<char>& data) const
+    {
+        VkPipelineCacheHeaderVersionOne header;
+        if (data.size() < sizeof(header))
+            return false;
+
+        std::memcpy(&header, data.data(), sizeof(header));
+
+        return header.headerSize >= sizeof(header)
+            && header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+            && header.vendorID == m_Properties.vendorID
+            && header.deviceID == m_Properties.deviceID
+            && std::memcmp(header.pipelineCacheUUID, m_Properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+    }
+
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan.hpp>
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace silica {
+
+    struct PipelineCacheStats
+    {
+        // true when the file existed and its header matched this device
+        bool Loaded = false;
+        size_t LoadedBytes = 0;
+        size_t SavedBytes = 0;
+        double LoadMilliseconds = 0.0;
+        double SaveMilliseconds = 0.0;
+        // pipelines created against this cache this run
+        uint32_t CreatedPipelines = 0;
+    };
+
+    // VkPipelineCache persisted between runs. The file is only used when its header
+    // matches the vendor, device and pipelineCacheUUID of the physical device.
+    // nvrhi creates its pipelines without a cache, so hookDispatch() wraps the dispatcher's
+    // pipeline creation to pass this one instead.
+    class VulkanPipelineCache
+    {
+    public:
+        VulkanPipelineCache() = default;
+        ~VulkanPipelineCache() = default;
+
+        // an empty path keeps the cache in memory only
+        void create(VkDevice device, const VkPhysicalDeviceProperties& properties, const VkAllocationCallbacks* allocator, const std::string& path);
+        // writes the cache to a temporary file and renames it over the old one
+        void save();
+        void destroy();
+
+        // after the dispatcher was initialized; only one cache can be hooked at a time
+        void hookDispatch(vk::detail::DispatchLoaderDynamic& dispatch);
+
+        VkPipelineCache getHandle() const { return m_Cache; }
+        PipelineCacheStats getStats() const;
+    private:
+        bool validateHeader(const std::vector<char>& data) const;
+
+        static VKAPI_ATTR VkResult VKAPI_CALL createGraphicsPipelines(VkDevice device, VkPipelineCache cache, uint32_t count,
+            const VkGraphicsPipelineCreateInfo* createInfos, const VkAllocationCallbacks* allocator, VkPipeline* pipelines);
+        static VKAPI_ATTR VkResult VKAPI_CALL createComputePipelines(VkDevice device, VkPipelineCache cache, uint32_t count,
+            const VkComputePipelineCreateInfo* createInfos, const VkAllocationCallbacks* allocator, VkPipeline* pipelines);
+    private:
+        VkDevice m_Device = nullptr;
+        const VkAllocationCallbacks* m_Allocator = nullptr;
+        VkPhysicalDeviceProperties m_Properties{};
+
+        VkPipelineCache m_Cache = nullptr;
+        std::string m_Path;
+
+        PipelineCacheStats m_Stats;
+        // pipelines are also created from PipelineLibrary's compile jobs
+        std::atomic<uint32_t> m_CreatedPipelines = 0;
+
+        vk::detail::DispatchLoaderDynamic* m_Dispatch = nullptr;
+        PFN_vkCreateGraphicsPipelines m_CreateGraphicsPipelines = nullptr;
+        PFN_vkCreateComputePipelines m_CreateComputePipelines = nullptr;
+
+        static VulkanPipelineCache* s_Hooked;
+    };
+
+}
@@ -0,0 +1,98 @@
+#include "VulkanReleaseQueue.h"
+
+#include "Core/Profiler.h"
+
+namespace silica {
+
+    void VulkanReleaseQueue::push(uint64_t gpuValue, std::shared_ptr<Resource> resource)
+    {
+        if (!resource)
+            return;
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Entries.push_back({ gpuValue, std::move(resource), nullptr });
+    }
+
+    void VulkanReleaseQueue::push(uint64_t gpuValue, std::function<void()> release)
+    {
+        if (!release)
+            return;
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Entries.push_back({ gpuValue, nullptr, std::move(release) });
+    }
+
+    void VulkanReleaseQueue::collect(uint64_t completedValue)
+    {
+        SIL_PROFILE_FUNCTION();
+
+        std::vector<Entry> retiring;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (m_Entries.empty() || m_Entries.front().GpuValue > completedValue)
+                return;
+
+            retiring.swap(m_Retiring);
+            while (!m_Entries.empty() && m_Entries.front().GpuValue <= completedValue)
+            {
+                retiring.push_back(std::move(m_Entries.front()));
+                m_Entries.pop_front();
+            }
+        }
+
+        for (Entry& entry : retiring)
+            retire(entry);
+        retiring.clear();
+
+        // hand the storage back so steady-state frames don't allocate
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (m_Retiring.capacity() < retiring.capacity())
+            m_Retiring.swap(retiring);
+    }
+
+    void VulkanReleaseQueue::flush()
+    {
+        // releases may queue more releases, e.g. a resource dropping the objects it owns
+        while (true)
+        {
+            std::deque<Entry> entries;
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                entries.swap(m_Entries);
+            }
+
+            if (entries.empty())
+                break;
+
+            for (Entry& entry : entries)
+                retire(entry);
+        }
+    }
+
+    size_t VulkanReleaseQueue::getPendingCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_Entries.size();
+    }
+
+    void VulkanReleaseQueue::retire(Entry& entry)
+    {
+        if (entry.Object)
+        {
+            if (entry.Object->isValid())
+            {
+                entry.Object->destroy();
+                entry.Object->invalidate();
+                entry.Object->m_Valid = false;
+            }
+            entry.Object = nullptr;
+        }
+
+        if (entry.Release)
+        {
+            entry.Release();
+            entry.Release = nullptr;
+        }
+    }
+
+}
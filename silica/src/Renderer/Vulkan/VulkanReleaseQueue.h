@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Renderer/Resource.h"
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace silica {
+
+    // Objects the GPU may still be using, destroyed once the timeline semaphore reaches the
+    // value they were released with. Entries are retired in release order, so one released
+    // with a lower value than an earlier entry waits for that entry too.
+    class VulkanReleaseQueue
+    {
+    public:
+        VulkanReleaseQueue() = default;
+        ~VulkanReleaseQueue() = default;
+
+        // calls destroy() and invalidate() on the resource, then drops the reference
+        void push(uint64_t gpuValue, std::shared_ptr<Resource> resource);
+        void push(uint64_t gpuValue, std::function<void()> release);
+
+        // retires everything released with a value up to completedValue
+        void collect(uint64_t completedValue);
+        // retires everything; the GPU must be idle
+        void flush();
+
+        size_t getPendingCount() const;
+    private:
+        struct Entry
+        {
+            uint64_t GpuValue = 0;
+            std::shared_ptr<Resource> Object;
+            std::function<void()> Release;
+        };
+
+        static void retire(Entry& entry);
+    private:
+        std::deque<Entry> m_Entries;
+        // entries are retired outside the lock so a release can queue further releases
+        std::vector<Entry> m_Retiring;
+        mutable std::mutex m_Mutex;
+    };
+
+}
@@ -0,0 +1,241 @@
+#include "VulkanUploadManager.h"
+
+#include "Core/Assert.h"
+#include "Core/Log.h"
+#include "Core/Profiler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace silica {
+
+    namespace utils {
+
+        static uint64_t alignUp(uint64_t value, uint64_t alignment)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+    }
+
+    void VulkanUploadManager::create(nvrhi::IDevice* device, uint64_t capacity, uint32_t framesInFlight, nvrhi::CommandQueue queue)
+    {
+        m_Device = device;
+        m_Queue = queue;
+        m_Capacity = capacity;
+
+        nvrhi::BufferDesc bufferDesc = nvrhi::BufferDesc()
+            .setByteSize(m_Capacity)
+            .setDebugName("Upload Ring")
+            .setCpuAccess(nvrhi::CpuAccessMode::Write)
+            .setInitialState(nvrhi::ResourceStates::CopySource)
+            .setKeepInitialState(true);
+
+        m_RingBuffer = m_Device->createBuffer(bufferDesc);
+        m_NativeRingBuffer = m_RingBuffer->getNativeObject(nvrhi::ObjectTypes::VK_Buffer);
+        m_RingData = static_cast<uint8_t*>(m_Device->mapBuffer(m_RingBuffer, nvrhi::CpuAccessMode::Write));
+
+        nvrhi::CommandListParameters params = nvrhi::CommandListParameters()
+            .setEnableImmediateExecution(false)
+            .setQueueType(m_Queue);
+
+        for (uint32_t i = 0; i < framesInFlight; i++)
+            m_CommandLists.push_back(m_Device->createCommandList(params));
+    }
+
+    void VulkanUploadManager::destroy()
+    {
+        if (m_RingBuffer)
+            m_Device->unmapBuffer(m_RingBuffer);
+
+        m_RingData = nullptr;
+        m_RingBuffer = nullptr;
+        m_CommandLists.clear();
+        m_DedicatedBuffers.clear();
+        m_PendingDedicatedBuffers.clear();
+        m_FrameMarks.clear();
+    }
+
+    void VulkanUploadManager::beginFrame(uint32_t frameIndex, uint64_t completedValue)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        m_FrameIndex = frameIndex;
+
+        while (!m_FrameMarks.empty() && m_FrameMarks.front().GpuValue <= completedValue)
+        {
+            m_Tail = m_FrameMarks.front().Head;
+            m_FrameMarks.pop_front();
+        }
+
+        auto it = std::remove_if(m_DedicatedBuffers.begin(), m_DedicatedBuffers.end(), [completedValue](const DedicatedBuffer& buffer)
+        {
+            return buffer.GpuValue <= completedValue;
+        });
+        m_DedicatedBuffers.erase(it, m_DedicatedBuffers.end());
+    }
+
+    nvrhi::ICommandList* VulkanUploadManager::endFrame(uint64_t frameValue)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        m_LastStats = m_CurrentStats;
+        m_CurrentStats = {};
+
+        if (!m_OpenCommandList)
+            return nullptr;
+
+        nvrhi::ICommandList* commandList = m_OpenCommandList;
+        commandList->close();
+        m_OpenCommandList = nullptr;
+
+        m_FrameMarks.push_back({ m_Head, frameValue });
+
+        for (nvrhi::BufferHandle& buffer : m_PendingDedicatedBuffers)
+            m_DedicatedBuffers.push_back({ std::move(buffer), frameValue });
+        m_PendingDedicatedBuffers.clear();
+
+        return commandList;
+    }
+
+    void VulkanUploadManager::uploadBuffer(nvrhi::IBuffer* buffer, const void* data, size_t size, uint64_t destOffset)
+    {
+        SIL_PROFILE_FUNCTION();
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        Allocation allocation = allocate(size, 16);
+        std::memcpy(allocation.CpuAddress, data, size);
+
+        getCommandList()->copyBuffer(buffer, destOffset, allocation.Buffer, allocation.Offset, size);
+
+        m_CurrentStats.BytesUploaded += size;
+        m_CurrentStats.Uploads++;
+    }
+
+    void VulkanUploadManager::uploadTexture(nvrhi::ITexture* texture, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch)
+    {
+        SIL_PROFILE_FUNCTION();
+
+        const nvrhi::TextureDesc& desc = texture->getDesc();
+        const nvrhi::FormatInfo& formatInfo = nvrhi::getFormatInfo(desc.format);
+
+        // buffer copies address one aspect at a time, each with its own packing, so a combined
+        // depth/stencil blob has no valid copy; depth-only formats are copied through the depth aspect
+        if (formatInfo.hasStencil)
+        {
+            SIL_ASSERT_OR_ERROR(false, "Uploading to depth/stencil format {} is not supported", formatInfo.name);
+            return;
+        }
+        VkImageAspectFlags aspectMask = formatInfo.hasDepth ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+
+        uint32_t width = std::max(1u, desc.width >> mipLevel);
+        uint32_t height = std::max(1u, desc.height >> mipLevel);
+        uint32_t depth = std::max(1u, desc.depth >> mipLevel);
+
+        uint32_t blocksWide = (width + formatInfo.blockSize - 1) / formatInfo.blockSize;
+        uint32_t blocksHigh = (height + formatInfo.blockSize - 1) / formatInfo.blockSize;
+
+        // rows are packed tightly in staging memory, so the copy can leave bufferRowLength at zero
+        uint64_t packedRowSize = (uint64_t)blocksWide * formatInfo.bytesPerBlock;
+        uint64_t packedSliceSize = packedRowSize * blocksHigh;
+        uint64_t size = packedSliceSize * depth;
+
+        if (depthPitch == 0)
+            depthPitch = rowPitch * blocksHigh;
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        // buffer offsets for image copies must be a multiple of both 4 and the texel block size
+        Allocation allocation = allocate(size, std::lcm<uint64_t>(formatInfo.bytesPerBlock, 256));
+
+        const uint8_t* source = static_cast<const uint8_t*>(data);
+        for (uint32_t z = 0; z < depth; z++)
+        {
+            for (uint32_t row = 0; row < blocksHigh; row++)
+                std::memcpy(allocation.CpuAddress + z * packedSliceSize + row * packedRowSize, source + z * depthPitch + row * rowPitch, packedRowSize);
+        }
+
+        nvrhi::ICommandList* commandList = getCommandList();
+
+        // nvrhi has no buffer-to-texture copy, so it only handles the layout transition
+        commandList->setTextureState(texture, nvrhi::TextureSubresourceSet(mipLevel, 1, arraySlice, 1), nvrhi::ResourceStates::CopyDest);
+        commandList->commitBarriers();
+
+        VkBufferImageCopy region{};
+        region.bufferOffset = allocation.Offset;
+        region.imageSubresource.aspectMask = aspectMask;
+        region.imageSubresource.mipLevel = mipLevel;
+        region.imageSubresource.baseArrayLayer = arraySlice;
+        region.imageSubresource.layerCount = 1;
+        region.imageExtent = { width, height, depth };
+
+        VkCommandBuffer commandBuffer = commandList->getNativeObject(nvrhi::ObjectTypes::VK_CommandBuffer);
+        VkImage image = texture->getNativeObject(nvrhi::ObjectTypes::VK_Image);
+        vkCmdCopyBufferToImage(commandBuffer, allocation.NativeBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+        m_CurrentStats.BytesUploaded += size;
+        m_CurrentStats.Uploads++;
+    }
+
+    UploadStats VulkanUploadManager::getLastFrameStats() const
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_LastStats;
+    }
+
+    VulkanUploadManager::Allocation VulkanUploadManager::allocate(uint64_t size, uint64_t alignment)
+    {
+        if (size <= m_Capacity)
+        {
+            uint64_t position = m_Head;
+            uint64_t offset = position % m_Capacity;
+            uint64_t alignedOffset = utils::alignUp(offset, alignment);
+
+            // never split an allocation across the end of the ring
+            if (alignedOffset + size > m_Capacity)
+                alignedOffset = m_Capacity;
+
+            position += alignedOffset - offset;
+            if (alignedOffset == m_Capacity)
+                alignedOffset = 0;
+
+            if (position + size - m_Tail <= m_Capacity)
+            {
+                m_Head = position + size;
+                return { m_RingBuffer, m_NativeRingBuffer, alignedOffset, m_RingData + alignedOffset };
+            }
+        }
+
+        // larger than the ring or the ring is still in use by the GPU
+        nvrhi::BufferDesc bufferDesc = nvrhi::BufferDesc()
+            .setByteSize(size)
+            .setDebugName("Upload Fallback")
+            .setCpuAccess(nvrhi::CpuAccessMode::Write)
+            .setInitialState(nvrhi::ResourceStates::CopySource)
+            .setKeepInitialState(true);
+
+        nvrhi::BufferHandle buffer = m_Device->createBuffer(bufferDesc);
+        m_PendingDedicatedBuffers.push_back(buffer);
+        m_CurrentStats.DedicatedFallbacks++;
+
+        SIL_TRACE("Upload of {} bytes did not fit the staging ring, using a dedicated buffer", size);
+
+        // mapped for good; the buffer is released once the GPU is done with it
+        void* cpuAddress = m_Device->mapBuffer(buffer, nvrhi::CpuAccessMode::Write);
+        return { buffer, buffer->getNativeObject(nvrhi::ObjectTypes::VK_Buffer), 0, static_cast<uint8_t*>(cpuAddress) };
+    }
+
+    nvrhi::ICommandList* VulkanUploadManager::getCommandList()
+    {
+        if (!m_OpenCommandList)
+        {
+            m_OpenCommandList = m_CommandLists[m_FrameIndex];
+            m_OpenCommandList->open();
+        }
+
+        return m_OpenCommandList;
+    }
+
+}
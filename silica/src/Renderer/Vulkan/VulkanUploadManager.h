@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Renderer/Device.h"
+
+#include <nvrhi/nvrhi.h>
+#include <vulkan/vulkan.h>
+
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace silica {
+
+    // Persistently mapped staging ring. Uploads are sub-allocated from it and
+    // recorded into one copy command list per frame.
+    class VulkanUploadManager
+    {
+    public:
+        VulkanUploadManager() = default;
+        ~VulkanUploadManager() = default;
+
+        void create(nvrhi::IDevice* device, uint64_t capacity, uint32_t framesInFlight, nvrhi::CommandQueue queue);
+        void destroy();
+
+        // releases ring space and fallback buffers of submissions up to completedValue
+        void beginFrame(uint32_t frameIndex, uint64_t completedValue);
+        // closes the frame's copy list; returns nullptr when nothing was uploaded
+        nvrhi::ICommandList* endFrame(uint64_t frameValue);
+
+        void uploadBuffer(nvrhi::IBuffer* buffer, const void* data, size_t size, uint64_t destOffset);
+        void uploadTexture(nvrhi::ITexture* texture, uint32_t arraySlice, uint32_t mipLevel, const void* data, size_t rowPitch, size_t depthPitch);
+
+        UploadStats getLastFrameStats() const;
+    private:
+        struct Allocation
+        {
+            nvrhi::IBuffer* Buffer = nullptr;
+            VkBuffer NativeBuffer = nullptr;
+            uint64_t Offset = 0;
+            uint8_t* CpuAddress = nullptr;
+        };
+
+        Allocation allocate(uint64_t size, uint64_t alignment);
+        nvrhi::ICommandList* getCommandList();
+    private:
+        struct FrameMark
+        {
+            uint64_t Head = 0;
+            uint64_t GpuValue = 0;
+        };
+
+        struct DedicatedBuffer
+        {
+            nvrhi::BufferHandle Buffer;
+            uint64_t GpuValue = 0;
+        };
+
+        nvrhi::IDevice* m_Device = nullptr;
+        nvrhi::CommandQueue m_Queue = nvrhi::CommandQueue::Graphics;
+
+        nvrhi::BufferHandle m_RingBuffer;
+        VkBuffer m_NativeRingBuffer = nullptr;
+        uint8_t* m_RingData = nullptr;
+        uint64_t m_Capacity = 0;
+
+        // monotonic byte positions; the live region is [m_Tail, m_Head)
+        uint64_t m_Head = 0;
+        uint64_t m_Tail = 0;
+        std::deque<FrameMark> m_FrameMarks;
+
+        std::vector<DedicatedBuffer> m_DedicatedBuffers;
+        std::vector<nvrhi::BufferHandle> m_PendingDedicatedBuffers;
+
+        std::vector<nvrhi::CommandListHandle> m_CommandLists;
+        uint32_t m_FrameIndex = 0;
+        // the list opened by the first upload; it can belong to the previous frame slot when the upload
+        // landed between endFrame and beginFrame, so endFrame submits this one rather than looking it up
+        nvrhi::ICommandList* m_OpenCommandList = nullptr;
+
+        UploadStats m_CurrentStats;
+        UploadStats m_LastStats;
+
+        mutable std::mutex m_Mutex;
+    };
+
+}
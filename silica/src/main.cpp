@@ -1,35 +1,119 @@
 #include <iostream>
+#include <cctype>
+#include <cstring>
+#include <string>
 
+#include "Core/JobSystem.h"
+#include "Core/Profiler.h"
 #include "Renderer/Device.h"
 #include "Renderer/Instance.h"
 
-int main()
+int main(int argc, char** argv)
 {
     SIL_SETUP_LOG({ &std::cout }, {}, "%c[%H:%M:%S] %m%c");
+    SIL_PROFILE_THREAD("Main");
 
-    glfwInit();
+    silica::JobSystem::init();
 
-    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-    GLFWwindow* window = glfwCreateWindow(1280, 720, "silica", nullptr, nullptr);
+    bool headless = false;
+    bool trackHostAllocations = false;
+    uint64_t headlessFrames = 1000;
+
+    silica::DeviceInfo deviceInfo{};
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--headless") == 0)
+            headless = true;
+        else if (std::strcmp(argv[i], "--track-host-memory") == 0)
+            trackHostAllocations = true;
+        else if (std::strcmp(argv[i], "--bindless") == 0)
+            deviceInfo.EnableBindless = true;
+        else if (std::strcmp(argv[i], "--adapter") == 0 && i + 1 < argc)
+        {
+            // an enumeration index or part of the device name
+            const char* adapter = argv[++i];
+            if (std::isdigit((unsigned char)adapter[0]))
+                deviceInfo.AdapterIndex = std::stoi(adapter);
+            else
+                deviceInfo.AdapterName = adapter;
+        }
+        else if (std::strcmp(argv[i], "--adapter-id") == 0 && i + 1 < argc)
+        {
+            // vendor:device in hex, e.g. 10de:2684; either side may be 0
+            std::string id = argv[++i];
+            size_t separator = id.find(':');
+            deviceInfo.AdapterVendorID = (uint32_t)std::stoul(id.substr(0, separator), nullptr, 16);
+            if (separator != std::string::npos)
+                deviceInfo.AdapterDeviceID = (uint32_t)std::stoul(id.substr(separator + 1), nullptr, 16);
+        }
+        else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            headlessFrames = std::stoull(argv[++i]);
+        else if (std::strcmp(argv[i], "--frames-in-flight") == 0 && i + 1 < argc)
+            deviceInfo.FramesInFlight = (uint32_t)std::stoul(argv[++i]);
+        else if (std::strcmp(argv[i], "--present") == 0 && i + 1 < argc)
+        {
+            const char* mode = argv[++i];
+            if (std::strcmp(mode, "fifo") == 0)
+                deviceInfo.PreferredPresentMode = silica::PresentMode::Fifo;
+            else if (std::strcmp(mode, "fifo-relaxed") == 0)
+                deviceInfo.PreferredPresentMode = silica::PresentMode::FifoRelaxed;
+            else if (std::strcmp(mode, "mailbox") == 0)
+                deviceInfo.PreferredPresentMode = silica::PresentMode::Mailbox;
+            else if (std::strcmp(mode, "immediate") == 0)
+                deviceInfo.PreferredPresentMode = silica::PresentMode::Immediate;
+        }
+    }
+
+    GLFWwindow* window = nullptr;
+
+    if (!headless)
+    {
+        glfwInit();
+
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+        window = glfwCreateWindow(1280, 720, "silica", nullptr, nullptr);
+    }
 
     silica::InstanceInfo instanceInfo{};
     instanceInfo.API = silica::RendererAPI::Vulkan;
     instanceInfo.Window = window;
-
-    silica::DeviceInfo deviceInfo{};
+    instanceInfo.Headless = headless;
+    instanceInfo.TrackHostAllocations = trackHostAllocations;
 
     std::unique_ptr<silica::Instance> instance = silica::createInstance(instanceInfo);
     std::shared_ptr<silica::Device> device = instance->createDevice(deviceInfo);
 
+    if (headless)
+    {
+        for (uint64_t frame = 0; frame < headlessFrames; frame++)
+        {
+            if (device->beginFrame())
+                device->endFrame();
+        }
+
+        SIL_PROFILE_WRITE_TRACE("silica_trace.json");
+        silica::JobSystem::shutdown();
+        return 0;
+    }
+
     while (!glfwWindowShouldClose(window))
     {
-        device->beginFrame();
+        if (!device->beginFrame())
+        {
+            glfwWaitEvents();
+            continue;
+        }
 
         device->endFrame();
 
         glfwPollEvents();
     }
 
+    SIL_PROFILE_WRITE_TRACE("silica_trace.json");
+
+    silica::JobSystem::shutdown();
+
     glfwDestroyWindow(window);
     glfwTerminate();
 }